@@ -0,0 +1,377 @@
+//
+//  bench.c
+//  sim
+//
+//  Fixed workloads run headless against sokol's dummy backend (or the
+//  software renderer with -s), reported as JSON. Built by `make bench`,
+//  `make bench-run` also runs it.
+//
+//  usage: sim_bench [-w warmup] [-r repetitions] [-s threads]
+//                   [-b baseline.json] [-t threshold%] [-o out.json]
+//
+
+#include "sim.h"
+#include "sokol/sokol_time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(BENCH_WIDTH)
+#define BENCH_WIDTH 640
+#endif
+
+#if !defined(BENCH_HEIGHT)
+#define BENCH_HEIGHT 480
+#endif
+
+#define BENCH_TEXTURES 16
+
+// `make bench` compiles sim.c with malloc/calloc/realloc/free renamed to
+// these, so every allocation the library makes is counted
+static unsigned long long allocations = 0;
+
+void* bench_malloc(size_t size) {
+    allocations++;
+    return malloc(size);
+}
+
+void* bench_calloc(size_t count, size_t size) {
+    allocations++;
+    return calloc(count, size);
+}
+
+void* bench_realloc(void *ptr, size_t size) {
+    allocations++;
+    return realloc(ptr, size);
+}
+
+void bench_free(void *ptr) {
+    free(ptr);
+}
+
+typedef struct {
+    const char *name;
+    void(*run)(void);
+    int vertices;
+    int draws;
+} workload_t;
+
+static int textures[BENCH_TEXTURES];
+static int cube = 0;
+
+static void projection(void) {
+    sim_matrix_mode(SIM_MATRIXMODE_PROJECTION);
+    sim_load_identity();
+    sim_perspective(60.f, sim_window_aspect_ratio(), .1f, 100.f);
+    sim_matrix_mode(SIM_MATRIXMODE_MODELVIEW);
+    sim_load_identity();
+    sim_translate(0.f, 0.f, -50.f);
+}
+
+static void screen(void) {
+    sim_matrix_mode(SIM_MATRIXMODE_PROJECTION);
+    sim_load_identity();
+    sim_ortho(0.f, BENCH_WIDTH, BENCH_HEIGHT, 0.f, -1.f, 1.f);
+    sim_matrix_mode(SIM_MATRIXMODE_MODELVIEW);
+    sim_load_identity();
+}
+
+// 1M vertices through sim_vertex3f in a single batch
+static void bench_vertices(void) {
+    projection();
+    sim_begin(SIM_DRAW_TRIANGLES);
+    for (int i = 0; i < 1000000; i++) {
+        float f = (float)i;
+        sim_color4ub(i & 0xFF, (i >> 8) & 0xFF, 0x80, 0xFF);
+        sim_vertex3f(-20.f + (float)(i % 1000) * .04f, -20.f + (float)(i / 1000) * .04f, f * 1e-6f);
+    }
+    sim_draw();
+    sim_end();
+}
+
+// 10k small sim_begin/sim_end batches, each a single triangle
+static void bench_batches(void) {
+    screen();
+    for (int i = 0; i < 10000; i++) {
+        float x = (float)(i % 100) * 6.f, y = (float)(i / 100) * 4.f;
+        sim_begin(SIM_DRAW_TRIANGLES);
+        sim_color4ub(i & 0xFF, 0x80, 0x40, 0xFF);
+        sim_vertex2f(x, y);
+        sim_vertex2f(x + 6.f, y + 4.f);
+        sim_vertex2f(x, y + 4.f);
+        sim_draw();
+        sim_end();
+    }
+}
+
+// 100k sim_draw instances of a stored cube
+static void bench_instances(void) {
+    projection();
+    sim_begin(SIM_DRAW_TRIANGLES);
+    sim_load_buffer(cube);
+    for (int i = 0; i < 100000; i++) {
+        sim_push_matrix();
+        sim_translate((float)(i % 316) * .2f - 31.6f, (float)(i / 316) * .2f - 31.6f, 0.f);
+        sim_scale(.05f, .05f, .05f);
+        sim_draw();
+        sim_pop_matrix();
+    }
+    sim_end();
+}
+
+// 10k batches switching texture, blend mode and depth function every time
+static void bench_thrash(void) {
+    screen();
+    for (int i = 0; i < 10000; i++) {
+        float x = (float)(i % 100) * 6.f, y = (float)(i / 100) * 4.f;
+        sim_push_texture(textures[i % BENCH_TEXTURES]);
+        sim_blend_mode(i & 1 ? SIM_BLEND_BLEND : SIM_BLEND_NONE);
+        sim_depth_func(i & 2 ? SIM_CMP_ALWAYS : SIM_CMP_LESS_EQUAL);
+        sim_begin(SIM_DRAW_QUADS);
+        sim_texcoord2f(0.f, 0.f);
+        sim_vertex2f(x, y);
+        sim_texcoord2f(1.f, 0.f);
+        sim_vertex2f(x + 6.f, y);
+        sim_texcoord2f(1.f, 1.f);
+        sim_vertex2f(x + 6.f, y + 4.f);
+        sim_texcoord2f(0.f, 1.f);
+        sim_vertex2f(x, y + 4.f);
+        sim_draw();
+        sim_end();
+        sim_pop_texture();
+    }
+    sim_blend_mode(SIM_BLEND_NONE);
+    sim_depth_func(SIM_CMP_LESS_EQUAL);
+}
+
+// 100k sprites spread over a handful of textures, the sprite API's target
+// is doing this at 60 Hz on one core
+static void bench_sprites(void) {
+    screen();
+    for (int i = 0; i < 100000; i++)
+        sim_sprite(textures[(i / 1000) % 4],
+                   (float)(i % 640), (float)((i * 7) % 480), 8.f, 8.f,
+                   0.f, 0.f, 1.f, 1.f, 0xFFFFFFFFu, (float)i * .01f);
+}
+
+// Fill rate, 64 blended full screen quads; only the software renderer
+// does the raster work
+static void bench_fill(void) {
+    screen();
+    sim_blend_mode(SIM_BLEND_BLEND);
+    sim_depth_func(SIM_CMP_ALWAYS);
+    for (int i = 0; i < 64; i++) {
+        sim_push_texture(textures[i % BENCH_TEXTURES]);
+        sim_begin(SIM_DRAW_QUADS);
+        sim_color4ub(0xFF, 0xFF, 0xFF, 0x20);
+        sim_texcoord2f(0.f, 0.f);
+        sim_vertex2f(0.f, 0.f);
+        sim_texcoord2f(4.f, 0.f);
+        sim_vertex2f(BENCH_WIDTH, 0.f);
+        sim_texcoord2f(4.f, 4.f);
+        sim_vertex2f(BENCH_WIDTH, BENCH_HEIGHT);
+        sim_texcoord2f(0.f, 4.f);
+        sim_vertex2f(0.f, BENCH_HEIGHT);
+        sim_draw();
+        sim_end();
+        sim_pop_texture();
+    }
+    sim_blend_mode(SIM_BLEND_NONE);
+    sim_depth_func(SIM_CMP_LESS_EQUAL);
+}
+
+static workload_t workloads[] = {
+    {"vertices",  bench_vertices,  1000000, 1},
+    {"batches",   bench_batches,   30000,   10000},
+    {"instances", bench_instances, 3600000, 100000},
+    {"thrash",    bench_thrash,    40000,   10000},
+    {"sprites",   bench_sprites,   400000,  100000},
+    {"fill",      bench_fill,      256,     64}
+};
+#define WORKLOAD_COUNT ((int)(sizeof(workloads) / sizeof(workloads[0])))
+
+static struct {
+    int warmup, repetitions, threads;
+    const char *baseline, *output;
+    double threshold;
+    // per frame CPU time and allocations, measured frames only
+    double *frame_ms[WORKLOAD_COUNT];
+    unsigned long long allocations[WORKLOAD_COUNT];
+    int frame;
+    uint64_t frame_start;
+    unsigned long long frame_allocations;
+} bench = {
+    .warmup = 10,
+    .repetitions = 50,
+    .threshold = 10.
+};
+
+static void init(void) {
+    for (int i = 0; i < BENCH_TEXTURES; i++)
+        textures[i] = sim_empty_texture(16 + i, 16 + i);
+
+    static const float cube_vertices[8][3] = {
+        {-1.f, -1.f, -1.f}, { 1.f, -1.f, -1.f}, { 1.f,  1.f, -1.f}, {-1.f,  1.f, -1.f},
+        {-1.f, -1.f,  1.f}, { 1.f, -1.f,  1.f}, { 1.f,  1.f,  1.f}, {-1.f,  1.f,  1.f}
+    };
+    static const int cube_indices[36] = {
+        0, 1, 2, 0, 2, 3, 6, 5, 4, 7, 6, 4,
+        0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2,
+        0, 4, 5, 0, 5, 1, 3, 2, 6, 3, 6, 7
+    };
+    sim_begin(SIM_DONT_CARE);
+    for (int i = 0; i < 8; i++)
+        sim_vertex3f(cube_vertices[i][0], cube_vertices[i][1], cube_vertices[i][2]);
+    sim_index_array(cube_indices, 36);
+    cube = sim_store_buffer();
+    sim_end();
+}
+
+// Each loop call closes the previous frame, so the measured time covers
+// that frame's recording and its submit walk
+static void loop(double t) {
+    (void)t;
+    uint64_t now = stm_now();
+    int per_workload = bench.warmup + bench.repetitions;
+    if (bench.frame > 0) {
+        int previous = bench.frame - 1;
+        int rep = previous % per_workload - bench.warmup;
+        if (rep >= 0) {
+            int index = previous / per_workload;
+            bench.frame_ms[index][rep] = stm_ms(stm_diff(now, bench.frame_start));
+            bench.allocations[index] += allocations - bench.frame_allocations;
+        }
+    }
+    bench.frame_start = stm_now();
+    bench.frame_allocations = allocations;
+    if (bench.frame < WORKLOAD_COUNT * per_workload)
+        workloads[bench.frame / per_workload].run();
+    bench.frame++;
+}
+
+static int compare_ms(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p) {
+    int index = (int)(p * (double)count + .999999) - 1;
+    return sorted[index < 0 ? 0 : index >= count ? count - 1 : index];
+}
+
+static char* read_file(const char *path) {
+    FILE *fh = fopen(path, "rb");
+    if (!fh)
+        return NULL;
+    fseek(fh, 0, SEEK_END);
+    long size = ftell(fh);
+    fseek(fh, 0, SEEK_SET);
+    char *result = malloc(size + 1);
+    if (result) {
+        result[fread(result, 1, size, fh)] = '\0';
+    }
+    fclose(fh);
+    return result;
+}
+
+// Only reads back what this program writes, one object per workload with
+// "name" ahead of "p50_ms"
+static double baseline_p50(const char *json, const char *name) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char *entry = json ? strstr(json, key) : NULL;
+    const char *value = entry ? strstr(entry, "\"p50_ms\":") : NULL;
+    return value ? atof(value + strlen("\"p50_ms\":")) : -1.;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: sim_bench [-w warmup] [-r repetitions] [-s threads] [-b baseline.json] [-t threshold%%] [-o out.json]\n");
+    exit(2);
+}
+
+int main(int argc, const char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || !argv[i][1] || argv[i][2] || i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+        switch (argv[i - 1][1]) {
+            case 'w':
+                bench.warmup = atoi(value);
+                break;
+            case 'r':
+                bench.repetitions = atoi(value);
+                break;
+            case 's':
+                bench.threads = atoi(value);
+                break;
+            case 'b':
+                bench.baseline = value;
+                break;
+            case 't':
+                bench.threshold = atof(value);
+                break;
+            case 'o':
+                bench.output = value;
+                break;
+            default:
+                usage();
+        }
+    }
+    if (bench.warmup < 0 || bench.repetitions < 1)
+        usage();
+
+    for (int i = 0; i < WORKLOAD_COUNT; i++)
+        if (!(bench.frame_ms[i] = calloc(bench.repetitions, sizeof(double))))
+            return 1;
+
+    sim_set_init_callback(init);
+    sim_set_loop_callback(loop);
+    sim_set_software_renderer(bench.threads);
+    // one extra frame closes the timing of the last measured one, the only
+    // failure sim_run_headless reports is not getting a device
+    if (sim_run_headless(BENCH_WIDTH, BENCH_HEIGHT, WORKLOAD_COUNT * (bench.warmup + bench.repetitions) + 1)) {
+        fprintf(stderr, "sim_bench: no headless device, build with SOKOL_DUMMY_BACKEND\n");
+        return 1;
+    }
+
+    char *baseline = NULL;
+    if (bench.baseline && !(baseline = read_file(bench.baseline))) {
+        fprintf(stderr, "sim_bench: can't read baseline '%s'\n", bench.baseline);
+        return 1;
+    }
+
+    FILE *out = bench.output ? fopen(bench.output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "sim_bench: can't write '%s'\n", bench.output);
+        return 1;
+    }
+    int regressions = 0;
+    fprintf(out, "{\n  \"renderer\": \"%s\",\n  \"threads\": %d,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"workloads\": [\n",
+            bench.threads ? "software" : "dummy", bench.threads, bench.warmup, bench.repetitions);
+    for (int i = 0; i < WORKLOAD_COUNT; i++) {
+        workload_t *w = &workloads[i];
+        double *ms = bench.frame_ms[i];
+        qsort(ms, bench.repetitions, sizeof(double), compare_ms);
+        double p50 = percentile(ms, bench.repetitions, .5);
+        double p99 = percentile(ms, bench.repetitions, .99);
+        fprintf(out, "    {\"name\": \"%s\", \"vertices\": %d, \"draws\": %d, \"ns_per_vertex\": %.3f, \"ns_per_draw\": %.3f, \"allocations\": %.1f, \"p50_ms\": %.4f, \"p99_ms\": %.4f",
+                w->name, w->vertices, w->draws, p50 * 1e6 / w->vertices, p50 * 1e6 / w->draws,
+                (double)bench.allocations[i] / bench.repetitions, p50, p99);
+        if (baseline) {
+            double base = baseline_p50(baseline, w->name);
+            int regressed = base > 0. && p50 > base * (1. + bench.threshold / 100.);
+            if (regressed) {
+                fprintf(stderr, "sim_bench: %s regressed, p50 %.4fms against %.4fms\n", w->name, p50, base);
+                regressions++;
+            }
+            fprintf(out, ", \"baseline_p50_ms\": %.4f, \"regressed\": %s", base, regressed ? "true" : "false");
+        }
+        fprintf(out, "}%s\n", i + 1 < WORKLOAD_COUNT ? "," : "");
+        free(ms);
+    }
+    fprintf(out, "  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    free(baseline);
+    return regressions ? 1 : 0;
+}
@@ -1,12 +1,7 @@
 @ctype vec4 hmm_vec4
 @ctype mat4 hmm_mat4
 
-@vs vs
-in vec4 position;
-in vec3 normal;
-in vec2 texcoord;
-in vec4 color_v;
-
+@block vs_common
 in vec4 inst_mat_x;
 in vec4 inst_mat_y;
 in vec4 inst_mat_z;
@@ -42,12 +37,70 @@ mat4 make_matrix(vec4 x, vec4 y, vec4 z, vec4 w) {
     return m;
 }
 
-void main() {
+void emit(vec4 position, vec3 normal, vec2 texcoord, vec4 color) {
     mat4 modelview = make_matrix(inst_mat_x, inst_mat_y, inst_mat_z, inst_mat_w);
     gl_Position = (projection * modelview) * position;
     out_texcoord = texture_matrix * vec4(texcoord, 0.0, 1.0);
     out_normal = normal;
-    out_color = color_v;
+    out_color = color;
+}
+@end
+
+// float4 position, float3 normal, float2 texcoord, float4 color
+@vs vs
+in vec4 position;
+in vec3 normal;
+in vec2 texcoord;
+in vec4 color_v;
+@include_block vs_common
+
+void main() {
+    emit(position, normal, texcoord, color_v);
+}
+@end
+
+// float2/float3 position, float2 texcoord, ubyte4n color
+@vs vs_uv
+in vec4 position;
+in vec2 texcoord;
+in vec4 color_v;
+@include_block vs_common
+
+void main() {
+    emit(position, vec3(0.0), texcoord, color_v);
+}
+@end
+
+// float3 position, ubyte4n color
+@vs vs_col
+in vec4 position;
+in vec4 color_v;
+@include_block vs_common
+
+void main() {
+    emit(position, vec3(0.0), vec2(0.0), color_v);
+}
+@end
+
+// float3 position, half2 texcoord, short2n octahedral normal, ubyte4n color
+@vs vs_oct
+in vec4 position;
+in vec2 texcoord;
+in vec2 normal_oct;
+in vec4 color_v;
+@include_block vs_common
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * s;
+    }
+    return normalize(n);
+}
+
+void main() {
+    emit(position, oct_decode(normal_oct), texcoord, color_v);
 }
 @end
 
@@ -61,8 +114,11 @@ in vec4 out_color;
 out vec4 frag_color;
 
 void main() {
-    frag_color = texture(sampler2D(texture_v, sampler_v), out_texcoord.xy) * color;
+    frag_color = texture(sampler2D(texture_v, sampler_v), out_texcoord.xy) * out_color;
 }
 @end
 
 @program sim vs fs
+@program sim_uv vs_uv fs
+@program sim_col vs_col fs
+@program sim_oct vs_oct fs
@@ -24,9 +24,32 @@
  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
 #include "sim.h"
+#include <limits.h>
 #define SOKOL_IMPL
 #define SOKOL_NO_ENTRY
+// sokol_app still needs the platform's 3D API to build with the dummy
+// backend (headless runs never open its window), so only sokol_gfx is
+// kept from seeing it
+#if defined(SOKOL_DUMMY_BACKEND)
+#pragma push_macro("SOKOL_GLCORE33")
+#pragma push_macro("SOKOL_GLCORE")
+#pragma push_macro("SOKOL_GLES3")
+#pragma push_macro("SOKOL_METAL")
+#pragma push_macro("SOKOL_D3D11")
+#undef SOKOL_GLCORE33
+#undef SOKOL_GLCORE
+#undef SOKOL_GLES3
+#undef SOKOL_METAL
+#undef SOKOL_D3D11
+#endif
 #include "sokol/sokol_gfx.h"
+#if defined(SOKOL_DUMMY_BACKEND)
+#pragma pop_macro("SOKOL_GLCORE33")
+#pragma pop_macro("SOKOL_GLCORE")
+#pragma pop_macro("SOKOL_GLES3")
+#pragma pop_macro("SOKOL_METAL")
+#pragma pop_macro("SOKOL_D3D11")
+#endif
 #include "sokol/sokol_app.h"
 #include "sokol/sokol_glue.h"
 #include "sokol/sokol_time.h"
@@ -42,6 +65,22 @@
 #define STB_NO_GIF
 #include "stb_image.h"
 
+#if defined(SOKOL_GLCORE33) || defined(SOKOL_GLCORE) || defined(SOKOL_GLES3)
+#define SIM_GL
+#endif
+
+// Headless runs on Linux can get their GL context through EGL without any
+// display server, everywhere else they need SOKOL_DUMMY_BACKEND
+#if defined(SIM_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if !defined(SIM_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define SIM_SSE
+#include <xmmintrin.h>
+#endif
+
 #if defined(SIM_WINDOWS)
 #include <windows.h>
 #include <io.h>
@@ -102,6 +141,66 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 #define MAX_MATRIX_STACK 32
 #endif
 
+#if !defined(MAX_PIPELINE_CACHE)
+#define MAX_PIPELINE_CACHE 64
+#endif
+
+#if !defined(MAX_SAMPLER_CACHE)
+#define MAX_SAMPLER_CACHE 32
+#endif
+
+// Worker recorders per context
+#if !defined(MAX_RECORDERS)
+#define MAX_RECORDERS 64
+#endif
+
+// 16384 quads keeps every index of the shared quad index buffer in 16 bits
+#if !defined(MAX_QUAD_COUNT)
+#define MAX_QUAD_COUNT 16384
+#endif
+
+#if !defined(DEFAULT_SPRITE_CAPACITY)
+#define DEFAULT_SPRITE_CAPACITY 1024
+#endif
+
+#if !defined(DEFAULT_ATLAS_PADDING)
+#define DEFAULT_ATLAS_PADDING 1
+#endif
+
+#if !defined(DEFAULT_RETAIN_FRAMES)
+#define DEFAULT_RETAIN_FRAMES 60
+#endif
+
+// Batches holding retained buffers across every context, each holds up to
+// two of sokol's buffer_pool_size buffers
+#if !defined(MAX_RETAINED_BATCHES)
+#define MAX_RETAINED_BATCHES 64
+#endif
+
+#if !defined(SOFT_TILE_SIZE)
+#define SOFT_TILE_SIZE 64
+#endif
+
+#if !defined(MAX_SOFT_TRIANGLES)
+#define MAX_SOFT_TRIANGLES 65536
+#endif
+
+#if !defined(MAX_SOFT_THREADS)
+#define MAX_SOFT_THREADS 64
+#endif
+
+#if !defined(DEFAULT_VERTEX_STREAM_SIZE)
+#define DEFAULT_VERTEX_STREAM_SIZE (1 << 20)
+#endif
+
+#if !defined(DEFAULT_INSTANCE_STREAM_SIZE)
+#define DEFAULT_INSTANCE_STREAM_SIZE (1 << 16)
+#endif
+
+#if !defined(DEFAULT_INDEX_STREAM_SIZE)
+#define DEFAULT_INDEX_STREAM_SIZE (1 << 18)
+#endif
+
 typedef struct {
     int down;
     uint64_t timestamp;
@@ -135,6 +234,62 @@ typedef struct {
     hmm_vec4 color;
 } sim_vertex_t;
 
+typedef struct {
+    float x, y;
+    float u, v;
+    uint8_t color[4];
+} sim_vertex_pos2_uv_rgba8_t;
+
+typedef struct {
+    float x, y, z;
+    float u, v;
+    uint8_t color[4];
+} sim_vertex_pos3_uv_rgba8_t;
+
+typedef struct {
+    float x, y, z;
+    uint8_t color[4];
+} sim_vertex_pos3_rgba8_t;
+
+typedef struct {
+    float x, y, z;
+    uint16_t uv[2];
+    int16_t normal[2];
+    uint8_t color[4];
+} sim_vertex_pos3_half_uv_oct_rgba8_t;
+
+// What the default format strips batches down to, color stays float so
+// nothing is lost
+typedef struct {
+    float x, y;
+    float u, v;
+    float color[4];
+} sim_vertex_pos2_uv_color_t;
+
+typedef struct {
+    float x, y, z;
+    float u, v;
+    float color[4];
+} sim_vertex_pos3_uv_color_t;
+
+typedef struct {
+    float x, y, z;
+    float color[4];
+} sim_vertex_pos3_color_t;
+
+enum {
+    SIM_ATTR_Z        = 0x1,
+    SIM_ATTR_NORMAL   = 0x2,
+    SIM_ATTR_TEXCOORD = 0x4
+};
+
+typedef struct {
+    int stride;
+    int position_size;
+    sg_shader shader;
+    sg_vertex_layout_state layout;
+} sim_vertex_format_t;
+
 enum {
     SIM_CMD_VIEWPORT,
     SIM_CMD_SCISSOR_RECT,
@@ -146,15 +301,40 @@ typedef struct {
 } sim_rect_t;
 
 typedef struct {
-    sim_vertex_t *vertices;
+    sg_filter min_filter, mag_filter;
+    sg_wrap wrap_u, wrap_v;
+} sim_sampler_key_t;
+
+// Everything a draw's pipeline and sampler are built from besides its
+// vertex format, so they can be resolved away from the recording thread.
+typedef struct {
+    sg_primitive_type primitive_type;
+    sg_index_type index_type;
+    sg_cull_mode cull_mode;
+    sg_depth_state depth;
+    sg_blend_state blend;
+    sim_sampler_key_t sampler;
+    int layer;
+} sim_draw_state_t;
+
+typedef struct {
     int vcount;
-    sim_vs_inst_t *instances;
     int icount;
     hmm_mat4 projection, texture_matrix;
     sg_pipeline pip;
     sg_bindings bind;
     sg_image texture;
-    int keep_vbuf;
+    int vstream;
+    int voffset;
+    int ioffset;
+    int index_stream;
+    int index_offset;
+    int index_count;
+    int keep_pip;
+    int keep_smp;
+    int format;
+    sim_draw_state_t state;
+    uint64_t sort_key;
 } sim_draw_call_t;
 
 typedef struct {
@@ -162,25 +342,371 @@ typedef struct {
     int matrix_mode;
     sg_color clear_color;
     sim_draw_call_t draw_call;
+    int in_batch;
     sim_vertex_t current_vertex;
+    int current_attrs;
+    int batch_attrs;
+    int batch_format;
+    int quads;
+    int vertex_format;
     sg_pipeline_desc pip_desc;
     sg_blend_state blend;
     int blend_mode;
+    int layer;
     sg_image current_texture;
     sg_sampler_desc sampler_desc;
-    sg_buffer current_buffer;
+    int current_buffer;
 } sim_state_t;
 
-typedef struct sim_command_t {
-    void *data;
+typedef struct {
+    sg_buffer vbuf, ibuf;
+    int vcount, index_count;
+    sg_index_type index_type;
+    int format;
+} sim_buffer_t;
+
+// Draw state sprites are grouped under, changing any of it flushes them
+typedef struct {
+    sg_blend_state blend;
+    sg_depth_state depth;
+    sg_filter min_filter, mag_filter;
+    sg_wrap wrap_u, wrap_v;
+    int layer;
+    hmm_mat4 projection;
+    hmm_mat4 texture_matrix;
+} sim_sprite_state_t;
+
+typedef struct {
+    sg_image texture;
+    sim_vertex_pos2_uv_rgba8_t *vertices;
+    int count, capacity;
+} sim_sprite_bucket_t;
+
+typedef struct {
+    uint64_t hash;
+    int vsize, isize;
+    int format;
+    sg_buffer vbuf, ibuf;
+    void *data; // vertices then indices, set along with the buffers
+    uint64_t last_used;
+} sim_retain_entry_t;
+
+// Batches seen with identical contents in more than one place are moved
+// into immutable buffers. entries is unordered, table maps hashes to
+// entry indices with linear probing and is rebuilt whenever it changes size.
+typedef struct {
+    int frames;
+    sim_retain_entry_t *entries;
+    int count, capacity;
+    int *table;
+    int table_size;
+} sim_retain_cache_t;
+
+typedef struct {
+    int x, y, width;
+} sim_skyline_node_t;
+
+typedef struct {
+    sg_image image;
+    int *pixels;
+    sim_skyline_node_t *nodes;
+    int node_count;
+    int dirty;
+    // sokol only allows one update per image per frame
+    uint64_t uploaded;
+} sim_atlas_page_t;
+
+typedef struct {
+    int page;
+    float u0, v0, u1, v1;
+} sim_atlas_region_t;
+
+typedef struct {
+    int width, height, padding;
+    sim_atlas_page_t *pages;
+    int page_count;
+    sim_atlas_region_t *regions;
+    int region_count, region_capacity;
+} sim_atlas_t;
+
+typedef struct {
+    sim_sprite_state_t state;
+    sim_sprite_bucket_t *buckets;
+    int bucket_count, bucket_capacity;
+    int last_bucket;
+    int pending;
+    int flushing;
+} sim_sprite_batch_t;
+
+typedef struct {
+    sg_shader shader;
+    sg_primitive_type primitive_type;
+    sg_index_type index_type;
+    sg_cull_mode cull_mode;
+    sg_depth_state depth;
+    sg_blend_state blend;
+    sg_vertex_layout_state layout;
+} sim_pipeline_key_t;
+
+typedef struct {
+    sim_pipeline_key_t key;
+    uint64_t hash;
+    sg_pipeline pip;
+    uint64_t last_used;
+    int pins;
+} sim_pipeline_cache_entry_t;
+
+typedef struct {
+    sim_pipeline_cache_entry_t entries[MAX_PIPELINE_CACHE];
+    int count;
+    int hits, misses;
+} sim_pipeline_cache_t;
+
+typedef struct {
+    sim_sampler_key_t keys[MAX_SAMPLER_CACHE];
+    sg_sampler samplers[MAX_SAMPLER_CACHE];
+    int count;
+} sim_sampler_cache_t;
+
+typedef struct {
+    sg_buffer buf;
+    sg_buffer_type type;
+    unsigned char *data;
+    int size, capacity;
+    int gpu_capacity, high_water;
+    int base, used;
+} sim_stream_t;
+
+typedef struct {
     int type;
-    struct sim_command_t *next;
+    union {
+        sim_rect_t rect;
+        sim_draw_call_t draw_call;
+    };
 } sim_command_t;
 
 typedef struct {
-    sim_command_t *head, *tail;
+    sim_command_t *commands;
+    int count, capacity;
 } sim_command_queue_t;
 
+// A compiled display list. Vertices and indices live in immutable buffers,
+// instances are kept on the CPU so replays can apply the caller's modelview.
+typedef struct {
+    sim_command_t *commands;
+    int count;
+    sg_buffer vbuf, ibuf;
+    sim_vs_inst_t *instances;
+    int instance_count;
+    // sim.frame_index when sim_release_list was called
+    uint64_t released;
+} sim_list_t;
+
+typedef struct {
+    int active;
+    int command_start;
+    int voffset, ioffset, index_offset;
+    hmm_mat4 modelview;
+    int retain_frames;
+} sim_list_recorder_t;
+
+// Everything immediate-mode recording touches. The loop callback records
+// into the main recorder, worker threads into their own, and frame()
+// merges the workers' into the main one in handle order.
+typedef struct {
+    sim_state_t state;
+    sim_command_queue_t commands;
+    sim_stream_t vertices;
+    sim_stream_t instances;
+    sim_stream_t indices;
+    sim_sprite_batch_t sprites;
+    // in vertices, the stream holds batches of different strides
+    int vertex_high_water;
+    int bound;
+} sim_recorder_t;
+
+typedef struct {
+    uint64_t key;
+    int index;
+} sim_sort_item_t;
+
+typedef struct {
+    sim_sort_item_t *items, *tmp;
+    int item_capacity;
+    sim_command_t *commands;
+    int capacity;
+} sim_sort_buffer_t;
+
+#if !defined(SIM_EMSCRIPTEN)
+#define SIM_THREADS
+#include <stdatomic.h>
+#if defined(SIM_WINDOWS)
+typedef HANDLE sim_thread_t;
+#else
+#include <pthread.h>
+#include <sched.h>
+typedef pthread_t sim_thread_t;
+#endif
+#endif
+
+// Pipelined mode runs the loop callback on its own thread, one frame ahead
+// of submission. The two recorders are handed back and forth through
+// go/ready: the main thread stores the slot to record next in go, the loop
+// thread stores the slot it finished in ready. Each side only ever waits
+// on the value the other one writes.
+typedef struct {
+    int enabled;
+    int started;
+    int in_flight;
+    sim_recorder_t recorders[2];
+    sim_input_t input;
+    double t;
+    double loop_ms;
+#if defined(SIM_THREADS)
+    sim_thread_t thread;
+    _Atomic int go;
+    _Atomic int ready;
+#endif
+} sim_pipeline_t;
+
+// Everything one renderer records and submits. Resources (textures,
+// buffers, atlases, display lists) and the pipeline and sampler caches
+// are shared by all contexts, like objects shared between GL contexts.
+struct sim_context_t {
+    sim_recorder_t main;
+    // allocated one by one and never moved, other threads keep pointers
+    // to the ones they have bound
+    sim_recorder_t *recorders[MAX_RECORDERS];
+    int recorder_count;
+    sim_retain_cache_t retain;
+    sim_list_recorder_t list_recorder;
+    uint64_t frame_index;
+    // sim.frame_index when this context last submitted, pipelines used
+    // since then may still be referenced by its commands
+    uint64_t pipeline_epoch;
+    int draw_order;
+    sim_sort_buffer_t sort;
+    sim_context_t *next;
+};
+
+typedef struct {
+    sg_image color, depth, resolve;
+    sg_attachments attachments;
+    int width, height;
+    // what the software renderer draws into instead, bottom row first like GL
+    unsigned char *soft_color;
+    float *soft_depth;
+} sim_render_target_t;
+
+// CPU copies of buffers and images for the software renderer, by sokol id
+typedef struct {
+    uint32_t id;
+    unsigned char *data;
+    int size;
+    int width, height;
+    int owned;
+} sim_soft_shadow_t;
+
+typedef struct {
+    sim_soft_shadow_t *entries;
+    int count, capacity;
+} sim_soft_shadows_t;
+
+// A vertex in clip space, then after projection window x, y, depth and 1/w
+// with the attributes divided by w for perspective correct interpolation
+typedef struct {
+    hmm_vec4 position;
+    float u, v;
+    hmm_vec4 color;
+} sim_soft_vertex_t;
+
+typedef struct {
+    const unsigned char *texels;
+    int tex_width, tex_height;
+    sim_sampler_key_t sampler;
+    sg_blend_state blend;
+    sg_compare_func depth_compare;
+    int depth_write;
+    float viewport[4];
+    // viewport, scissor and target intersected, max exclusive
+    int minx, miny, maxx, maxy;
+} sim_soft_draw_t;
+
+// Edge i is opposite vertex i, a*x + b*y + c is its barycentric weight
+// scaled by the area, positive inside
+typedef struct {
+    float a[3], b[3], c[3];
+    int top_left[3];
+    float inv_area;
+    float z[3], w[3], u[3], v[3];
+    hmm_vec4 color[3];
+    int minx, miny, maxx, maxy;
+    int draw;
+    int minify;
+} sim_soft_triangle_t;
+
+typedef struct {
+    int *items;
+    int count, capacity;
+} sim_soft_bin_t;
+
+// Draws are transformed and set up on the submitting thread, binned into
+// screen tiles, then tiles are rasterized in parallel. Each tile is owned
+// by one thread and walks its bin in submission order, so the result is
+// the same for any thread count.
+typedef struct {
+    int enabled;
+    int thread_count;
+    sim_soft_shadows_t buffers, images;
+    unsigned char *color;
+    float *depth;
+    int width, height;
+    int tiles_x, tiles_y;
+    int clear;
+    unsigned char clear_color[4];
+    sim_soft_draw_t *draws;
+    int draw_count, draw_capacity;
+    sim_soft_triangle_t *triangles;
+    int triangle_count;
+    sim_soft_bin_t *bins;
+    int bin_count;
+    sim_soft_vertex_t *vertices, *transformed;
+    int vertex_capacity;
+#if defined(SIM_THREADS)
+    sim_thread_t threads[MAX_SOFT_THREADS];
+    int started;
+    // idle workers sleep on wake until generation or quit changes
+#if defined(SIM_WINDOWS)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+    _Atomic int generation;
+    _Atomic int next_tile;
+    _Atomic int done;
+    _Atomic int quit;
+#endif
+} sim_soft_t;
+
+typedef struct {
+    int enabled;
+    int width, height;
+    int target;
+    unsigned char *pixels;
+#if defined(SIM_EGL)
+    EGLDisplay display;
+    EGLContext context;
+#endif
+} sim_headless_t;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIM_THREAD_LOCAL __declspec(thread)
+#else
+#define SIM_THREAD_LOCAL _Thread_local
+#endif
+
 static struct sim_t {
     int running;
     int mouse_hidden;
@@ -192,9 +718,31 @@ static struct sim_t {
     void *userdata;
     sim_input_t current_input;
     sim_input_t last_input;
-    sim_state_t state;
-    sim_command_queue_t commands;
-    sg_shader shader;
+    sim_context_t context;
+    sim_context_t *contexts;
+    sim_pipeline_t pipeline;
+    sim_headless_t headless;
+    sim_soft_t soft;
+    sim_state_t default_state;
+    sim_pipeline_cache_t pipelines;
+    sim_sampler_cache_t samplers;
+    sg_buffer quad_indices;
+    sim_buffer_t *buffers;
+    int buffer_count;
+    int retained_count;
+    sim_list_t *lists;
+    int list_count;
+    sim_list_t *released_lists;
+    int released_list_count, released_list_capacity;
+    sim_atlas_t *atlases;
+    int atlas_count;
+    sim_render_target_t *targets;
+    int target_count;
+    uint64_t frame_index;
+    uint64_t commit_count;
+    sim_frame_stats_t stats;
+    sim_frame_stats_t last_stats;
+    sim_vertex_format_t formats[SIM_VERTEX_FORMAT_COUNT];
 } sim = {
     .running = 0,
     .mouse_hidden = 0,
@@ -207,14 +755,124 @@ static struct sim_t {
     .userdata = NULL
 };
 
+// NULL on every thread that hasn't made a context current, which then
+// uses the default context
+static SIM_THREAD_LOCAL sim_context_t *sim_thread_context = NULL;
+// NULL on every thread that hasn't bound a recorder with sim_recorder_begin()
+static SIM_THREAD_LOCAL sim_recorder_t *sim_thread_recorder = NULL;
+
+static sim_context_t* sim_context(void) {
+    return sim_thread_context ? sim_thread_context : &sim.context;
+}
+
+static sim_recorder_t* sim_recorder(void) {
+    return sim_thread_recorder ? sim_thread_recorder : &sim_context()->main;
+}
+
+// Only the default context's main recorder is known to be recorded on the
+// main thread. Everything else may be on any thread, so its draws leave
+// sokol and the shared caches alone until they are merged or submitted.
+static int sim_recording_on_main_thread(void) {
+    return !sim_thread_recorder && !sim_thread_context;
+}
+
+// Every pipeline, sampler and buffer the library makes or destroys, and
+// every upload, goes through these so sim_frame_stats can count them
+static sg_pipeline sim_make_pipeline(const sg_pipeline_desc *desc) {
+    sim.stats.pipelines_created++;
+    return sg_make_pipeline(desc);
+}
+
+static void sim_destroy_pipeline(sg_pipeline pip) {
+    if (pip.id != SG_INVALID_ID)
+        sim.stats.pipelines_destroyed++;
+    sg_destroy_pipeline(pip);
+}
+
+static sg_sampler sim_make_sampler(const sg_sampler_desc *desc) {
+    sim.stats.samplers_created++;
+    return sg_make_sampler(desc);
+}
+
+static void sim_destroy_sampler(sg_sampler smp) {
+    if (smp.id != SG_INVALID_ID)
+        sim.stats.samplers_destroyed++;
+    sg_destroy_sampler(smp);
+}
+
+static sg_buffer sim_make_buffer(const sg_buffer_desc *desc) {
+    sim.stats.buffers_created++;
+    sim.stats.bytes_uploaded += desc->data.size;
+    return sg_make_buffer(desc);
+}
+
+static void sim_destroy_buffer(sg_buffer buf) {
+    if (buf.id != SG_INVALID_ID)
+        sim.stats.buffers_destroyed++;
+    sg_destroy_buffer(buf);
+}
+
+static int sim_append_buffer(sg_buffer buf, const sg_range *data) {
+    sim.stats.bytes_uploaded += data->size;
+    return sg_append_buffer(buf, data);
+}
+
+static void sim_update_image(sg_image img, const sg_image_data *data) {
+    for (int face = 0; face < SG_CUBEFACE_NUM; face++)
+        for (int mip = 0; mip < SG_MAX_MIPMAPS; mip++)
+            sim.stats.bytes_uploaded += data->subimage[face][mip].size;
+    sg_update_image(img, data);
+}
+
+// Only kept while the software renderer is enabled. Buffers and loaded
+// textures are copied, atlas pages and render targets point at memory
+// that lives as long as the image.
+static void sim_soft_shadow(sim_soft_shadows_t *table, uint32_t id, const void *data, int size, int width, int height, int owned) {
+    if (!sim.soft.enabled || id == SG_INVALID_ID)
+        return;
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? table->capacity * 2 : 64;
+        table->entries = realloc(table->entries, table->capacity * sizeof(sim_soft_shadow_t));
+        assert(table->entries);
+    }
+    sim_soft_shadow_t *entry = &table->entries[table->count++];
+    entry->id = id;
+    entry->size = size;
+    entry->width = width;
+    entry->height = height;
+    entry->owned = owned;
+    if (owned) {
+        entry->data = malloc(size ? size : 1);
+        assert(entry->data);
+        memcpy(entry->data, data, size);
+    } else
+        entry->data = (unsigned char*)data;
+}
+
+static sim_soft_shadow_t* sim_soft_find(sim_soft_shadows_t *table, uint32_t id) {
+    for (int i = table->count - 1; i >= 0; i--)
+        if (table->entries[i].id == id)
+            return &table->entries[i];
+    return NULL;
+}
+
+static void sim_soft_forget(sim_soft_shadows_t *table, uint32_t id) {
+    sim_soft_shadow_t *entry = sim_soft_find(table, id);
+    if (!entry)
+        return;
+    if (entry->owned)
+        free(entry->data);
+    *entry = table->entries[--table->count];
+}
+
 static hmm_mat4* sim_matrix_stack_head(int mode) {
     assert(mode >= 0 && mode < SIM_MATRIXMODE_COUNT);
-    sim_matrix_stack_t *stack = &sim.state.matrix_stack[mode];
+    sim_matrix_stack_t *stack = &sim_recorder()->state.matrix_stack[mode];
     return stack->count ? &stack->stack[stack->count-1] : NULL;
 }
 
 static hmm_mat4* sim_current_matrix(void) {
-    return sim_matrix_stack_head(sim.state.matrix_mode);
+    return sim_matrix_stack_head(sim_recorder()->state.matrix_mode);
 }
 
 static void sim_set_current_matrix(hmm_mat4 mat) {
@@ -222,160 +880,2431 @@ static void sim_set_current_matrix(hmm_mat4 mat) {
     *head = mat;
 }
 
-static void sim_push_vertex(void) {
-    sim.state.draw_call.vertices = realloc(sim.state.draw_call.vertices, ++sim.state.draw_call.vcount * sizeof(sim_vertex_t));
-    memcpy(&sim.state.draw_call.vertices[sim.state.draw_call.vcount-1], &sim.state.current_vertex, sizeof(sim_vertex_t));
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
 }
 
-static void sim_push_command(int type, void *data) {
-    sim_command_t *command = malloc(sizeof(sim_command_t));
-    command->type = type;
-    command->data = data;
-    command->next = NULL;
-    
-    if (!sim.commands.head && !sim.commands.tail)
-        sim.commands.head = sim.commands.tail = command;
-    else {
-        sim.commands.tail->next = command;
-        sim.commands.tail = command;
-    }
+static uint64_t xxh_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(uint64_t));
+    return v;
 }
 
-static void init(void) {
-    sg_desc desc = {
-        .environment = sglue_environment(),
-        .logger.func = slog_func,
-        .buffer_pool_size = 256
-    };
-    sg_setup(&desc);
-    stm_setup();
-    
-    sim.shader = sg_make_shader(sim_shader_desc(sg_query_backend()));
-    sim.state.pip_desc = (sg_pipeline_desc) {
-        .layout = {
-            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
-            .attrs = {
-                [ATTR_vs_position] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=0 },
-                [ATTR_vs_normal] = { .format=SG_VERTEXFORMAT_FLOAT3, .buffer_index=0 },
-                [ATTR_vs_texcoord] = { .format=SG_VERTEXFORMAT_FLOAT2, .buffer_index=0 },
-                [ATTR_vs_color_v] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=0 },
-                [ATTR_vs_inst_mat_x] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },
-                [ATTR_vs_inst_mat_y] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },
-                [ATTR_vs_inst_mat_z] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },
-                [ATTR_vs_inst_mat_w] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 }
-            }
-        },
-        .shader = sim.shader,
-        .cull_mode = SG_CULLMODE_BACK,
-        .depth = {
-            .compare = SG_COMPAREFUNC_LESS_EQUAL,
-            .write_enabled = true
-        }
-    };
-    
-    for (int i = 0; i < SIM_MATRIXMODE_COUNT; i++) {
-        sim_matrix_stack_t *stack = &sim.state.matrix_stack[i];
-        stack->count = 1;
-        stack->stack[0] = HMM_Mat4();
-    }
-    
-    sim.state.matrix_stack[SIM_MATRIXMODE_TEXTURE].stack[0] = HMM_Mat4d(1.f);
-    sim.state.blend_mode = -1;
-    sim_blend_mode(SIM_BLEND_DEFAULT);
-    sim.state.pip_desc.depth.compare = -1;
-    sim_depth_func(SIM_CMP_DEFAULT);
-    sim.state.pip_desc.cull_mode = -1;
-    sim_cull_mode(SIM_CULL_DEFAULT);
-    
-    if (sim.init)
-        sim.init();
+static uint32_t xxh_read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
 }
 
-static void frame(void) {
-    const float t = (float)(sapp_frame_duration() * 60.);
-    sim.loop(t);
+static uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    return xxh_rotl(acc, 31) * XXH_PRIME64_1;
+}
 
-    sg_begin_pass(&(sg_pass) {
-        .action = {
-            .colors[0] = {
-                .load_action = SG_LOADACTION_CLEAR,
-                .clear_value = sim.state.clear_color
-            }
-        },
-        .swapchain = sglue_swapchain()
-    });
-    sim_command_t *cursor = sim.commands.head;
-    while (cursor) {
-        sim_command_t *tmp = cursor->next;
-        switch (cursor->type) {
-            case SIM_CMD_VIEWPORT:
-            case SIM_CMD_SCISSOR_RECT:;
-                sim_rect_t *rect = (sim_rect_t*)cursor->data;
-                if (cursor->type == SIM_CMD_VIEWPORT)
-                    sim_viewport(rect->x, rect->y, rect->w, rect->h);
-                else
-                    sim_scissor_rect(rect->x, rect->y, rect->w, rect->h);
-                break;
-            case SIM_CMD_DRAW_CALL:;
-                sim_draw_call_t *call = (sim_draw_call_t*)cursor->data;
-                sg_apply_pipeline(call->pip);
-                sg_apply_bindings(&call->bind);
-                vs_params_t vs_params;
-                vs_params.texture_matrix = call->texture_matrix;
-                vs_params.projection = call->projection;
-                sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &SG_RANGE(vs_params));
-                sg_draw(0, call->vcount, call->icount);
-                if (!call->keep_vbuf)
-                    sg_destroy_buffer(call->bind.vertex_buffers[0]);
-                sg_destroy_buffer(call->bind.vertex_buffers[1]);
-                sg_destroy_sampler(call->bind.fs.samplers[SLOT_sampler_v]);
-                sg_destroy_pipeline(call->pip);
-                break;
-            default:
-                abort();
+static uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+// XXH64, for hashing whole vertex streams where FNV-1a is too slow
+static uint64_t sim_hash_xxh64(const void *data, size_t size, uint64_t seed) {
+    const unsigned char *p = (const unsigned char*)data;
+    const unsigned char *end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
         }
-        free(cursor->data);
-        free(cursor);
-        cursor = tmp;
+        h = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else
+        h = seed + XXH_PRIME64_5;
+    h += (uint64_t)size;
+    for (; p + 8 <= end; p += 8)
+        h = xxh_rotl(h ^ xxh_round(0, xxh_read64(p)), 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    if (p + 4 <= end) {
+        h = xxh_rotl(h ^ ((uint64_t)xxh_read32(p) * XXH_PRIME64_1), 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
     }
-    sim.commands.head = sim.commands.tail = NULL;
-    sg_end_pass();
-    sg_commit();
-    
-    memcpy(&sim.last_input, &sim.current_input, sizeof(sim_input_t));
-    memset(&sim.current_input, 0, sizeof(sim_input_t));
+    for (; p < end; p++)
+        h = xxh_rotl(h ^ (*p * XXH_PRIME64_5), 11) * XXH_PRIME64_1;
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
 }
 
-static void event(const sapp_event *e) {
-    switch (e->type) {
-        case SAPP_EVENTTYPE_KEY_UP:
+static uint64_t sim_hash(const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char*)data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// The oldest frame any context may still have unsubmitted commands from
+static uint64_t sim_pipeline_epoch(void) {
+    uint64_t result = sim.frame_index;
+    for (sim_context_t *ctx = sim.contexts; ctx; ctx = ctx->next)
+        if (ctx->main.commands.count && ctx->pipeline_epoch < result)
+            result = ctx->pipeline_epoch;
+    return result;
+}
+
+// Returns a pipeline matching a draw's format and state, creating it if needed.
+// Entries not used during the current frame and not pinned by a display
+// list are evicted least-recently-used first. If every entry is still
+// referenced the pipeline is returned uncached and *cached is set to 0, the
+// caller is then responsible for destroying it after the draw.
+static sg_pipeline sim_find_pipeline(const sim_draw_call_t *call, int *cached) {
+    sim_pipeline_key_t key;
+    memset(&key, 0, sizeof(sim_pipeline_key_t));
+    key.shader = sim.formats[call->format].shader;
+    key.primitive_type = call->state.primitive_type;
+    key.index_type = call->state.index_type;
+    key.cull_mode = call->state.cull_mode;
+    key.depth = call->state.depth;
+    key.blend = call->state.blend;
+    key.layout = sim.formats[call->format].layout;
+    uint64_t hash = sim_hash(&key, sizeof(sim_pipeline_key_t));
+
+    sim_pipeline_cache_t *cache = &sim.pipelines;
+    for (int i = 0; i < cache->count; i++) {
+        sim_pipeline_cache_entry_t *entry = &cache->entries[i];
+        if (entry->hash == hash && !memcmp(&entry->key, &key, sizeof(sim_pipeline_key_t))) {
+            entry->last_used = sim.frame_index;
+            cache->hits++;
+            *cached = 1;
+            return entry->pip;
+        }
+    }
+    cache->misses++;
+
+    sg_pipeline pip = sim_make_pipeline(&(sg_pipeline_desc) {
+        .shader = key.shader,
+        .layout = key.layout,
+        .primitive_type = key.primitive_type,
+        .index_type = key.index_type,
+        .cull_mode = key.cull_mode,
+        .depth = key.depth,
+        .colors[0].blend = key.blend
+    });
+
+    sim_pipeline_cache_entry_t *entry = NULL;
+    if (cache->count < MAX_PIPELINE_CACHE)
+        entry = &cache->entries[cache->count++];
+    else {
+        for (int i = 0; i < cache->count; i++)
+            if (!cache->entries[i].pins && (!entry || cache->entries[i].last_used < entry->last_used))
+                entry = &cache->entries[i];
+        if (!entry || entry->last_used >= sim_pipeline_epoch()) {
+            *cached = 0;
+            return pip;
+        }
+        sim_destroy_pipeline(entry->pip);
+    }
+    entry->key = key;
+    entry->hash = hash;
+    entry->pip = pip;
+    entry->last_used = sim.frame_index;
+    *cached = 1;
+    return pip;
+}
+
+static void sim_pin_pipeline(sg_pipeline pip, int delta) {
+    for (int i = 0; i < sim.pipelines.count; i++)
+        if (sim.pipelines.entries[i].pip.id == pip.id) {
+            sim.pipelines.entries[i].pins += delta;
+            assert(sim.pipelines.entries[i].pins >= 0);
+            return;
+        }
+}
+
+// Samplers only vary by the handful of filter/wrap combinations, so they
+// are created once and kept for the lifetime of the app. If the cache is
+// full the sampler is returned uncached and *cached is set to 0.
+static sg_sampler sim_find_sampler(const sim_draw_call_t *call, int *cached) {
+    sim_sampler_key_t key = call->state.sampler;
+
+    sim_sampler_cache_t *cache = &sim.samplers;
+    for (int i = 0; i < cache->count; i++)
+        if (!memcmp(&cache->keys[i], &key, sizeof(sim_sampler_key_t))) {
+            *cached = 1;
+            return cache->samplers[i];
+        }
+
+    sg_sampler_desc desc = {
+        .min_filter = key.min_filter,
+        .mag_filter = key.mag_filter,
+        .wrap_u = key.wrap_u,
+        .wrap_v = key.wrap_v
+    };
+    sg_sampler smp = sim_make_sampler(&desc);
+    if (cache->count < MAX_SAMPLER_CACHE) {
+        cache->keys[cache->count] = key;
+        cache->samplers[cache->count++] = smp;
+        *cached = 1;
+    } else
+        *cached = 0;
+    return smp;
+}
+
+static void sim_stream_init(sim_stream_t *stream, sg_buffer_type type, int capacity) {
+    memset(stream, 0, sizeof(sim_stream_t));
+    stream->type = type;
+    stream->gpu_capacity = capacity;
+    stream->buf = sim_make_buffer(&(sg_buffer_desc) {
+        .size = capacity,
+        .type = type,
+        .usage = SG_USAGE_STREAM
+    });
+}
+
+// Makes room for at least size more bytes on the stream's CPU side and
+// returns where they will be written. Capacity grows geometrically and is
+// never given back, so steady-state recording doesn't touch the allocator.
+static void* sim_stream_reserve(sim_stream_t *stream, int size) {
+    if (stream->size + size > stream->capacity) {
+        int capacity = stream->capacity ? stream->capacity : 1024;
+        while (capacity < stream->size + size)
+            capacity *= 2;
+        stream->data = realloc(stream->data, capacity);
+        assert(stream->data);
+        stream->capacity = capacity;
+    }
+    return stream->data + stream->size;
+}
+
+static int next_pow2(int v) {
+    int result = 1;
+    while (result < v)
+        result <<= 1;
+    return result;
+}
+
+// Uploads everything pushed this frame with a single append. The GPU buffer
+// is only ever resized here, before anything has been appended to it, and
+// grows to the next power of two above the highest usage seen so far.
+static void sim_stream_upload(sim_stream_t *stream) {
+    if (stream->size > stream->high_water)
+        stream->high_water = stream->size;
+    if (stream->high_water > stream->gpu_capacity) {
+        sim_destroy_buffer(stream->buf);
+        stream->gpu_capacity = next_pow2(stream->high_water);
+        stream->buf = sim_make_buffer(&(sg_buffer_desc) {
+            .size = stream->gpu_capacity,
+            .type = stream->type,
+            .usage = SG_USAGE_STREAM
+        });
+    }
+    stream->base = 0;
+    if (stream->size)
+        stream->base = sim_append_buffer(stream->buf, &(sg_range) {
+            .ptr = stream->data,
+            .size = stream->size
+        });
+    stream->used = stream->size;
+    stream->size = 0;
+}
+
+static uint16_t float_to_half(float f) {
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    bits.f = f;
+    uint32_t sign = (bits.u >> 16) & 0x8000;
+    int exponent = (int)((bits.u >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits.u & 0x7FFFFF;
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+        return sign | half;
+    }
+    if (exponent >= 31)
+        return sign | 0x7C00 | (((bits.u >> 23) & 0xFF) == 0xFF && mantissa ? 0x200 : 0);
+    uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        half++;
+    return half;
+}
+
+static float half_to_float(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    int exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    if (!exponent) {
+        if (!mantissa)
+            bits.u = sign;
+        else {
+            exponent = 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits.u = sign | ((uint32_t)(exponent + 127 - 15) << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 31)
+        bits.u = sign | 0x7F800000 | (mantissa << 13);
+    else
+        bits.u = sign | ((uint32_t)(exponent + 127 - 15) << 23) | (mantissa << 13);
+    return bits.f;
+}
+
+static void oct_encode(hmm_vec3 n, int16_t *out) {
+    float l1 = fabsf(n.X) + fabsf(n.Y) + fabsf(n.Z);
+    float x = 0.f, y = 0.f;
+    if (l1 > 0.f) {
+        x = n.X / l1;
+        y = n.Y / l1;
+        if (n.Z < 0.f) {
+            float ox = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+            float oy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+            x = ox;
+            y = oy;
+        }
+    }
+    out[0] = (int16_t)roundf(x * 32767.f);
+    out[1] = (int16_t)roundf(y * 32767.f);
+}
+
+static hmm_vec3 oct_decode(const int16_t *in) {
+    float x = in[0] / 32767.f, y = in[1] / 32767.f;
+    x = x < -1.f ? -1.f : x;
+    y = y < -1.f ? -1.f : y;
+    hmm_vec3 n = HMM_Vec3(x, y, 1.f - fabsf(x) - fabsf(y));
+    if (n.Z < 0.f) {
+        n.X = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+        n.Y = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+    }
+    return HMM_NormalizeVec3(n);
+}
+
+static void pack_color(hmm_vec4 color, uint8_t *out) {
+    for (int i = 0; i < 4; i++) {
+        float c = color.Elements[i];
+        c = c < 0.f ? 0.f : c > 1.f ? 1.f : c;
+        out[i] = (uint8_t)(c * 255.f + .5f);
+    }
+}
+
+static hmm_vec4 unpack_color(const uint8_t *in) {
+    return HMM_Vec4(in[0] / 255.f, in[1] / 255.f, in[2] / 255.f, in[3] / 255.f);
+}
+
+// Expands a single vertex in any format back to a full vertex.
+static void sim_unpack_vertex(int format, const void *src, sim_vertex_t *out) {
+    memset(out, 0, sizeof(sim_vertex_t));
+    switch (format) {
+        case SIM_VERTEX_FORMAT_POS2_UV_RGBA8:;
+            const sim_vertex_pos2_uv_rgba8_t *a = (const sim_vertex_pos2_uv_rgba8_t*)src;
+            out->position = HMM_Vec4(a->x, a->y, 0.f, 1.f);
+            out->texcoord = HMM_Vec2(a->u, a->v);
+            out->color = unpack_color(a->color);
+            break;
+        case SIM_VERTEX_FORMAT_POS3_UV_RGBA8:;
+            const sim_vertex_pos3_uv_rgba8_t *b = (const sim_vertex_pos3_uv_rgba8_t*)src;
+            out->position = HMM_Vec4(b->x, b->y, b->z, 1.f);
+            out->texcoord = HMM_Vec2(b->u, b->v);
+            out->color = unpack_color(b->color);
+            break;
+        case SIM_VERTEX_FORMAT_POS3_RGBA8:;
+            const sim_vertex_pos3_rgba8_t *c = (const sim_vertex_pos3_rgba8_t*)src;
+            out->position = HMM_Vec4(c->x, c->y, c->z, 1.f);
+            out->color = unpack_color(c->color);
+            break;
+        case SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8:;
+            const sim_vertex_pos3_half_uv_oct_rgba8_t *d = (const sim_vertex_pos3_half_uv_oct_rgba8_t*)src;
+            out->position = HMM_Vec4(d->x, d->y, d->z, 1.f);
+            out->texcoord = HMM_Vec2(half_to_float(d->uv[0]), half_to_float(d->uv[1]));
+            out->normal = oct_decode(d->normal);
+            out->color = unpack_color(d->color);
+            break;
+        case SIM_VERTEX_FORMAT_POS2_UV_COLOR:;
+            const sim_vertex_pos2_uv_color_t *e = (const sim_vertex_pos2_uv_color_t*)src;
+            out->position = HMM_Vec4(e->x, e->y, 0.f, 1.f);
+            out->texcoord = HMM_Vec2(e->u, e->v);
+            memcpy(&out->color, e->color, sizeof(e->color));
+            break;
+        case SIM_VERTEX_FORMAT_POS3_UV_COLOR:;
+            const sim_vertex_pos3_uv_color_t *f = (const sim_vertex_pos3_uv_color_t*)src;
+            out->position = HMM_Vec4(f->x, f->y, f->z, 1.f);
+            out->texcoord = HMM_Vec2(f->u, f->v);
+            memcpy(&out->color, f->color, sizeof(f->color));
+            break;
+        case SIM_VERTEX_FORMAT_POS3_COLOR:;
+            const sim_vertex_pos3_color_t *g = (const sim_vertex_pos3_color_t*)src;
+            out->position = HMM_Vec4(g->x, g->y, g->z, 1.f);
+            memcpy(&out->color, g->color, sizeof(g->color));
+            break;
+        default:
+            memcpy(out, src, sizeof(sim_vertex_t));
+            break;
+    }
+}
+
+// Converts full vertices to a compact format in place. Every compact
+// format is smaller than sim_vertex_t so the output never overtakes the
+// input, each source vertex is copied out before its slot is reused.
+static void sim_pack_vertices(int format, void *dst, const sim_vertex_t *src, int count) {
+    sim_vertex_t v;
+    switch (format) {
+        case SIM_VERTEX_FORMAT_POS2_UV_RGBA8:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos2_uv_rgba8_t *out = (sim_vertex_pos2_uv_rgba8_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->u = v.texcoord.X;
+                out->v = v.texcoord.Y;
+                pack_color(v.color, out->color);
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS3_UV_RGBA8:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos3_uv_rgba8_t *out = (sim_vertex_pos3_uv_rgba8_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->z = v.position.Z;
+                out->u = v.texcoord.X;
+                out->v = v.texcoord.Y;
+                pack_color(v.color, out->color);
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS3_RGBA8:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos3_rgba8_t *out = (sim_vertex_pos3_rgba8_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->z = v.position.Z;
+                pack_color(v.color, out->color);
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos3_half_uv_oct_rgba8_t *out = (sim_vertex_pos3_half_uv_oct_rgba8_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->z = v.position.Z;
+                out->uv[0] = float_to_half(v.texcoord.X);
+                out->uv[1] = float_to_half(v.texcoord.Y);
+                oct_encode(v.normal, out->normal);
+                pack_color(v.color, out->color);
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS2_UV_COLOR:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos2_uv_color_t *out = (sim_vertex_pos2_uv_color_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->u = v.texcoord.X;
+                out->v = v.texcoord.Y;
+                memcpy(out->color, &v.color, sizeof(out->color));
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS3_UV_COLOR:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos3_uv_color_t *out = (sim_vertex_pos3_uv_color_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->z = v.position.Z;
+                out->u = v.texcoord.X;
+                out->v = v.texcoord.Y;
+                memcpy(out->color, &v.color, sizeof(out->color));
+            }
+            break;
+        case SIM_VERTEX_FORMAT_POS3_COLOR:
+            for (int i = 0; i < count; i++) {
+                v = src[i];
+                sim_vertex_pos3_color_t *out = (sim_vertex_pos3_color_t*)dst + i;
+                out->x = v.position.X;
+                out->y = v.position.Y;
+                out->z = v.position.Z;
+                memcpy(out->color, &v.color, sizeof(out->color));
+            }
+            break;
+        default:
+            if (dst != src)
+                memmove(dst, src, count * sizeof(sim_vertex_t));
+            break;
+    }
+}
+
+// Vertices are written straight into the frame's vertex stream, the
+// batch being the vcount vertices starting at draw_call.voffset. They are
+// kept as sim_vertex_t until sim_end() unless the batch was started with
+// sim_vertex_array(), in which case they are packed as they arrive.
+static void sim_push_vertex(void) {
+    sim_recorder_t *rec = sim_recorder();
+    int format = rec->state.batch_format;
+    int stride = format ? sim.formats[format].stride : (int)sizeof(sim_vertex_t);
+    void *dst = sim_stream_reserve(&rec->vertices, stride);
+    if (format)
+        sim_pack_vertices(format, dst, &rec->state.current_vertex, 1);
+    else
+        memcpy(dst, &rec->state.current_vertex, sizeof(sim_vertex_t));
+    rec->vertices.size += stride;
+    rec->state.draw_call.vcount++;
+    rec->state.batch_attrs |= rec->state.current_attrs;
+}
+
+// Commands are bump-allocated from a contiguous array that keeps its
+// capacity between frames, frame() resets it by setting count back to 0.
+static sim_command_t* sim_queue_push(sim_command_queue_t *queue, int type) {
+    if (queue->count == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 64;
+        queue->commands = realloc(queue->commands, queue->capacity * sizeof(sim_command_t));
+        assert(queue->commands);
+    }
+    sim_command_t *command = &queue->commands[queue->count++];
+    command->type = type;
+    return command;
+}
+
+static sim_command_t* sim_push_command(int type) {
+    return sim_queue_push(&sim_recorder()->commands, type);
+}
+
+// LSD radix sort on 8 bit digits, stable so draws with equal keys keep
+// their submission order. Digits that are the same for every key are skipped.
+static void radix_sort(sim_sort_item_t *items, sim_sort_item_t *tmp, int count) {
+    sim_sort_item_t *src = items, *dst = tmp;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256];
+        memset(offsets, 0, sizeof(offsets));
+        for (int i = 0; i < count; i++)
+            offsets[(src[i].key >> shift) & 0xFF]++;
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+        for (int i = 0, total = 0; i < 256; i++) {
+            int n = offsets[i];
+            offsets[i] = total;
+            total += n;
+        }
+        for (int i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        sim_sort_item_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != items)
+        memcpy(items, src, count * sizeof(sim_sort_item_t));
+}
+
+// Reorders runs of draw calls by their sort key. Viewport and scissor
+// commands act as barriers, nothing is moved across them.
+static void sim_sort_commands(sim_context_t *ctx) {
+    sim_recorder_t *rec = &ctx->main;
+    sim_sort_buffer_t *sort = &ctx->sort;
+    int count = rec->commands.count;
+    if (count < 2)
+        return;
+    if (sort->item_capacity < count) {
+        sort->item_capacity = rec->commands.capacity;
+        sort->items = realloc(sort->items, sort->item_capacity * sizeof(sim_sort_item_t));
+        sort->tmp = realloc(sort->tmp, sort->item_capacity * sizeof(sim_sort_item_t));
+        assert(sort->items && sort->tmp);
+    }
+    if (sort->capacity < count) {
+        sort->capacity = rec->commands.capacity;
+        sort->commands = realloc(sort->commands, sort->capacity * sizeof(sim_command_t));
+        assert(sort->commands);
+    }
+
+    sim_command_t *src = rec->commands.commands;
+    for (int start = 0; start < count;) {
+        if (src[start].type != SIM_CMD_DRAW_CALL) {
+            sort->commands[start] = src[start];
+            start++;
+            continue;
+        }
+        int end = start;
+        for (; end < count && src[end].type == SIM_CMD_DRAW_CALL; end++) {
+            sort->items[end - start].key = src[end].draw_call.sort_key;
+            sort->items[end - start].index = end;
+        }
+        radix_sort(sort->items, sort->tmp, end - start);
+        for (int i = start; i < end; i++)
+            sort->commands[i] = src[sort->items[i - start].index];
+        start = end;
+    }
+
+    sim_command_t *commands = rec->commands.commands;
+    int capacity = rec->commands.capacity;
+    rec->commands.commands = sort->commands;
+    rec->commands.capacity = sort->capacity;
+    sort->commands = commands;
+    sort->capacity = capacity;
+}
+
+#define SIM_INSTANCE_ATTRS(VS)                                                                   \
+    [ATTR_##VS##_inst_mat_x] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },              \
+    [ATTR_##VS##_inst_mat_y] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },              \
+    [ATTR_##VS##_inst_mat_z] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 },              \
+    [ATTR_##VS##_inst_mat_w] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=1 }
+
+static void sim_init_vertex_formats(void) {
+#if defined(SOKOL_DUMMY_BACKEND)
+    // the dummy backend never compiles shaders but still wants a desc
+    sg_backend backend = SG_BACKEND_METAL_MACOS;
+#else
+    sg_backend backend = sg_query_backend();
+#endif
+    sg_shader full = sg_make_shader(sim_shader_desc(backend));
+    sg_shader uv = sg_make_shader(sim_uv_shader_desc(backend));
+    sg_shader col = sg_make_shader(sim_col_shader_desc(backend));
+    sg_shader oct = sg_make_shader(sim_oct_shader_desc(backend));
+
+    sim.formats[SIM_VERTEX_FORMAT_FULL] = (sim_vertex_format_t) {
+        .stride = sizeof(sim_vertex_t),
+        .position_size = 4,
+        .shader = full,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_position] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=0 },
+                [ATTR_vs_normal] = { .format=SG_VERTEXFORMAT_FLOAT3, .buffer_index=0 },
+                [ATTR_vs_texcoord] = { .format=SG_VERTEXFORMAT_FLOAT2, .buffer_index=0 },
+                [ATTR_vs_color_v] = { .format=SG_VERTEXFORMAT_FLOAT4, .buffer_index=0 },
+                SIM_INSTANCE_ATTRS(vs)
+            }
+        }
+    };
+    sim.formats[SIM_VERTEX_FORMAT_POS2_UV_RGBA8] = (sim_vertex_format_t) {
+        .stride = sizeof(sim_vertex_pos2_uv_rgba8_t),
+        .position_size = 2,
+        .shader = uv,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_uv_position] = { .format=SG_VERTEXFORMAT_FLOAT2, .buffer_index=0 },
+                [ATTR_vs_uv_texcoord] = { .format=SG_VERTEXFORMAT_FLOAT2, .buffer_index=0 },
+                [ATTR_vs_uv_color_v] = { .format=SG_VERTEXFORMAT_UBYTE4N, .buffer_index=0 },
+                SIM_INSTANCE_ATTRS(vs_uv)
+            }
+        }
+    };
+    sim.formats[SIM_VERTEX_FORMAT_POS3_UV_RGBA8] = (sim_vertex_format_t) {
+        .stride = sizeof(sim_vertex_pos3_uv_rgba8_t),
+        .position_size = 3,
+        .shader = uv,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_uv_position] = { .format=SG_VERTEXFORMAT_FLOAT3, .buffer_index=0 },
+                [ATTR_vs_uv_texcoord] = { .format=SG_VERTEXFORMAT_FLOAT2, .buffer_index=0 },
+                [ATTR_vs_uv_color_v] = { .format=SG_VERTEXFORMAT_UBYTE4N, .buffer_index=0 },
+                SIM_INSTANCE_ATTRS(vs_uv)
+            }
+        }
+    };
+    sim.formats[SIM_VERTEX_FORMAT_POS3_RGBA8] = (sim_vertex_format_t) {
+        .stride = sizeof(sim_vertex_pos3_rgba8_t),
+        .position_size = 3,
+        .shader = col,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_col_position] = { .format=SG_VERTEXFORMAT_FLOAT3, .buffer_index=0 },
+                [ATTR_vs_col_color_v] = { .format=SG_VERTEXFORMAT_UBYTE4N, .buffer_index=0 },
+                SIM_INSTANCE_ATTRS(vs_col)
+            }
+        }
+    };
+    sim.formats[SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8] = (sim_vertex_format_t) {
+        .stride = sizeof(sim_vertex_pos3_half_uv_oct_rgba8_t),
+        .position_size = 3,
+        .shader = oct,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [ATTR_vs_oct_position] = { .format=SG_VERTEXFORMAT_FLOAT3, .buffer_index=0 },
+                [ATTR_vs_oct_texcoord] = { .format=SG_VERTEXFORMAT_HALF2, .buffer_index=0 },
+                [ATTR_vs_oct_normal_oct] = { .format=SG_VERTEXFORMAT_SHORT2N, .buffer_index=0 },
+                [ATTR_vs_oct_color_v] = { .format=SG_VERTEXFORMAT_UBYTE4N, .buffer_index=0 },
+                SIM_INSTANCE_ATTRS(vs_oct)
+            }
+        }
+    };
+    // the same shaders read a float color just as well as a normalized one
+    sim.formats[SIM_VERTEX_FORMAT_POS2_UV_COLOR] = sim.formats[SIM_VERTEX_FORMAT_POS2_UV_RGBA8];
+    sim.formats[SIM_VERTEX_FORMAT_POS2_UV_COLOR].stride = sizeof(sim_vertex_pos2_uv_color_t);
+    sim.formats[SIM_VERTEX_FORMAT_POS2_UV_COLOR].layout.attrs[ATTR_vs_uv_color_v].format = SG_VERTEXFORMAT_FLOAT4;
+    sim.formats[SIM_VERTEX_FORMAT_POS3_UV_COLOR] = sim.formats[SIM_VERTEX_FORMAT_POS3_UV_RGBA8];
+    sim.formats[SIM_VERTEX_FORMAT_POS3_UV_COLOR].stride = sizeof(sim_vertex_pos3_uv_color_t);
+    sim.formats[SIM_VERTEX_FORMAT_POS3_UV_COLOR].layout.attrs[ATTR_vs_uv_color_v].format = SG_VERTEXFORMAT_FLOAT4;
+    sim.formats[SIM_VERTEX_FORMAT_POS3_COLOR] = sim.formats[SIM_VERTEX_FORMAT_POS3_RGBA8];
+    sim.formats[SIM_VERTEX_FORMAT_POS3_COLOR].stride = sizeof(sim_vertex_pos3_color_t);
+    sim.formats[SIM_VERTEX_FORMAT_POS3_COLOR].layout.attrs[ATTR_vs_col_color_v].format = SG_VERTEXFORMAT_FLOAT4;
+}
+
+// Picks the smallest format that reproduces the batch exactly. Attributes
+// that stayed zero for every vertex are dropped, the shader variants
+// substitute zero for them, and colors are kept as floats.
+static int sim_auto_vertex_format(int attrs) {
+    if (attrs & SIM_ATTR_NORMAL)
+        return SIM_VERTEX_FORMAT_FULL;
+    if (!(attrs & SIM_ATTR_TEXCOORD))
+        return SIM_VERTEX_FORMAT_POS3_COLOR;
+    return attrs & SIM_ATTR_Z ? SIM_VERTEX_FORMAT_POS3_UV_COLOR : SIM_VERTEX_FORMAT_POS2_UV_COLOR;
+}
+
+// Every SIM_DRAW_QUADS batch is drawn through this one index buffer, quad
+// n being vertices 4n..4n+3 as two triangles (0,1,2) and (0,2,3).
+static void sim_init_quad_indices(void) {
+    uint16_t *indices = malloc(MAX_QUAD_COUNT * 6 * sizeof(uint16_t));
+    assert(indices);
+    for (int i = 0; i < MAX_QUAD_COUNT; i++) {
+        uint16_t *quad = indices + i * 6;
+        uint16_t v = (uint16_t)(i * 4);
+        quad[0] = v;
+        quad[1] = v + 1;
+        quad[2] = v + 2;
+        quad[3] = v;
+        quad[4] = v + 2;
+        quad[5] = v + 3;
+    }
+    sim.quad_indices = sim_make_buffer(&(sg_buffer_desc) {
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .data = (sg_range) {
+            .ptr = indices,
+            .size = MAX_QUAD_COUNT * 6 * sizeof(uint16_t)
+        }
+    });
+    sim_soft_shadow(&sim.soft.buffers, sim.quad_indices.id, indices, MAX_QUAD_COUNT * 6 * sizeof(uint16_t), 0, 0, 1);
+    free(indices);
+}
+
+static void init(void) {
+    sg_desc desc = {
+        .environment = sim.headless.enabled ? (sg_environment) {
+            .defaults = {
+                .color_format = SG_PIXELFORMAT_RGBA8,
+                .depth_format = SG_PIXELFORMAT_DEPTH_STENCIL,
+                .sample_count = 1
+            }
+        } : sglue_environment(),
+        .logger.func = slog_func,
+        .buffer_pool_size = 256,
+        .pipeline_pool_size = MAX_PIPELINE_CACHE * 2
+    };
+    sg_setup(&desc);
+    sg_enable_frame_stats();
+    stm_setup();
+    
+    sim_init_vertex_formats();
+    sim_context_t *ctx = &sim.context;
+    sim.contexts = ctx;
+    ctx->pipeline_epoch = sim.frame_index;
+    sim_stream_init(&ctx->main.vertices, SG_BUFFERTYPE_VERTEXBUFFER, DEFAULT_VERTEX_STREAM_SIZE);
+    sim_stream_init(&ctx->main.instances, SG_BUFFERTYPE_VERTEXBUFFER, DEFAULT_INSTANCE_STREAM_SIZE);
+    sim_stream_init(&ctx->main.indices, SG_BUFFERTYPE_INDEXBUFFER, DEFAULT_INDEX_STREAM_SIZE);
+    sim_init_quad_indices();
+    ctx->main.state.pip_desc = (sg_pipeline_desc) {
+        .layout = sim.formats[SIM_VERTEX_FORMAT_FULL].layout,
+        .shader = sim.formats[SIM_VERTEX_FORMAT_FULL].shader,
+        .cull_mode = SG_CULLMODE_BACK,
+        .depth = {
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true
+        }
+    };
+    
+    for (int i = 0; i < SIM_MATRIXMODE_COUNT; i++) {
+        sim_matrix_stack_t *stack = &ctx->main.state.matrix_stack[i];
+        stack->count = 1;
+        stack->stack[0] = HMM_Mat4();
+    }
+    
+    ctx->main.state.matrix_stack[SIM_MATRIXMODE_TEXTURE].stack[0] = HMM_Mat4d(1.f);
+    ctx->main.state.current_vertex.color = HMM_Vec4(1.f, 1.f, 1.f, 1.f);
+    sim_vertex_format(SIM_VERTEX_FORMAT_DEFAULT);
+    ctx->main.state.blend_mode = -1;
+    sim_blend_mode(SIM_BLEND_DEFAULT);
+    ctx->main.state.pip_desc.depth.compare = -1;
+    sim_depth_func(SIM_CMP_DEFAULT);
+    ctx->main.state.pip_desc.cull_mode = -1;
+    sim_cull_mode(SIM_CULL_DEFAULT);
+    sim.default_state = ctx->main.state;
+    if (sim.headless.enabled)
+        sim.headless.target = sim_render_target_create(sim.headless.width, sim.headless.height);
+    
+    if (sim.init)
+        sim.init();
+}
+
+static void sim_sprite_snapshot(sim_sprite_state_t *out) {
+    sim_recorder_t *rec = sim_recorder();
+    memset(out, 0, sizeof(sim_sprite_state_t));
+    out->blend = rec->state.blend;
+    out->depth = rec->state.pip_desc.depth;
+    out->min_filter = rec->state.sampler_desc.min_filter;
+    out->mag_filter = rec->state.sampler_desc.mag_filter;
+    out->wrap_u = rec->state.sampler_desc.wrap_u;
+    out->wrap_v = rec->state.sampler_desc.wrap_v;
+    out->layer = rec->state.layer;
+    out->projection = *sim_matrix_stack_head(SIM_MATRIXMODE_PROJECTION);
+    out->texture_matrix = *sim_matrix_stack_head(SIM_MATRIXMODE_TEXTURE);
+}
+
+// Draws every pending sprite, one quad batch per texture, through the
+// regular batch path so they merge, sort and share pipelines like any other
+// draw. The modelview was already applied on the CPU.
+static void sim_flush_sprites(void) {
+    sim_recorder_t *rec = sim_recorder();
+    sim_sprite_batch_t *sprites = &rec->sprites;
+    if (!sprites->pending || sprites->flushing)
+        return;
+    sprites->flushing = 1;
+
+    sim_state_t saved = rec->state;
+    rec->state.blend = sprites->state.blend;
+    rec->state.pip_desc.depth = sprites->state.depth;
+    rec->state.pip_desc.cull_mode = SG_CULLMODE_NONE;
+    rec->state.sampler_desc.min_filter = sprites->state.min_filter;
+    rec->state.sampler_desc.mag_filter = sprites->state.mag_filter;
+    rec->state.sampler_desc.wrap_u = sprites->state.wrap_u;
+    rec->state.sampler_desc.wrap_v = sprites->state.wrap_v;
+    rec->state.layer = sprites->state.layer;
+    *sim_matrix_stack_head(SIM_MATRIXMODE_PROJECTION) = sprites->state.projection;
+    *sim_matrix_stack_head(SIM_MATRIXMODE_TEXTURE) = sprites->state.texture_matrix;
+    *sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW) = HMM_Mat4d(1.f);
+    for (int i = 0; i < sprites->bucket_count; i++) {
+        sim_sprite_bucket_t *bucket = &sprites->buckets[i];
+        if (!bucket->count)
+            continue;
+        rec->state.current_texture = bucket->texture;
+        sim_begin(SIM_DRAW_QUADS);
+        sim_vertex_array(bucket->vertices, bucket->count * 4, 0, SIM_VERTEX_FORMAT_POS2_UV_RGBA8);
+        sim_draw();
+        sim_end();
+        bucket->count = 0;
+    }
+    // sim_end() clears the sampler description, the rest is untouched
+    rec->state = saved;
+
+    sprites->pending = 0;
+    sprites->flushing = 0;
+}
+
+static sim_sprite_bucket_t* sim_sprite_bucket(sg_image texture) {
+    sim_sprite_batch_t *sprites = &sim_recorder()->sprites;
+    if (sprites->last_bucket < sprites->bucket_count &&
+        sprites->buckets[sprites->last_bucket].texture.id == texture.id)
+        return &sprites->buckets[sprites->last_bucket];
+    for (int i = 0; i < sprites->bucket_count; i++)
+        if (sprites->buckets[i].texture.id == texture.id) {
+            sprites->last_bucket = i;
+            return &sprites->buckets[i];
+        }
+
+    if (sprites->bucket_count == sprites->bucket_capacity) {
+        int capacity = sprites->bucket_capacity ? sprites->bucket_capacity * 2 : 8;
+        sim_sprite_bucket_t *buckets = realloc(sprites->buckets, capacity * sizeof(sim_sprite_bucket_t));
+        assert(buckets);
+        sprites->buckets = buckets;
+        sprites->bucket_capacity = capacity;
+    }
+    sim_sprite_bucket_t *bucket = &sprites->buckets[sprites->bucket_count];
+    memset(bucket, 0, sizeof(sim_sprite_bucket_t));
+    bucket->texture = texture;
+    sprites->last_bucket = sprites->bucket_count++;
+    return bucket;
+}
+
+static sim_vertex_pos2_uv_rgba8_t* sim_sprite_reserve(sim_sprite_bucket_t *bucket) {
+    if (bucket->count == bucket->capacity) {
+        int capacity = bucket->capacity ? bucket->capacity * 2 : DEFAULT_SPRITE_CAPACITY;
+        sim_vertex_pos2_uv_rgba8_t *vertices = realloc(bucket->vertices, capacity * 4 * sizeof(sim_vertex_pos2_uv_rgba8_t));
+        assert(vertices);
+        bucket->vertices = vertices;
+        bucket->capacity = capacity;
+    }
+    return bucket->vertices + bucket->count++ * 4;
+}
+
+static void sim_retain_rebuild(void) {
+    sim_retain_cache_t *cache = &sim_context()->retain;
+    int size = next_pow2(cache->count * 2 > 64 ? cache->count * 2 : 64);
+    if (size != cache->table_size) {
+        free(cache->table);
+        cache->table = malloc(size * sizeof(int));
+        assert(cache->table);
+        cache->table_size = size;
+    }
+    memset(cache->table, -1, size * sizeof(int));
+    for (int i = 0; i < cache->count; i++) {
+        int slot = (int)(cache->entries[i].hash & (size - 1));
+        while (cache->table[slot] != -1)
+            slot = (slot + 1) & (size - 1);
+        cache->table[slot] = i;
+    }
+}
+
+// Turns an entry back into a remembered hash
+static void sim_retain_release(sim_retain_entry_t *entry) {
+    if (entry->vbuf.id == SG_INVALID_ID)
+        return;
+    sim_soft_forget(&sim.soft.buffers, entry->vbuf.id);
+    sim_soft_forget(&sim.soft.buffers, entry->ibuf.id);
+    sim_destroy_buffer(entry->vbuf);
+    if (entry->ibuf.id != SG_INVALID_ID)
+        sim_destroy_buffer(entry->ibuf);
+    entry->vbuf.id = SG_INVALID_ID;
+    entry->ibuf.id = SG_INVALID_ID;
+    free(entry->data);
+    entry->data = NULL;
+    sim.retained_count--;
+}
+
+// Drops retained buffers that went unused for the configured number of frames
+static void sim_retain_evict(sim_context_t *ctx) {
+    sim_retain_cache_t *cache = &ctx->retain;
+    int evicted = 0;
+    for (int i = 0; i < cache->count; i++) {
+        sim_retain_entry_t *entry = &cache->entries[i];
+        if (entry->last_used + cache->frames >= ctx->frame_index)
+            continue;
+        sim_retain_release(entry);
+        *entry = cache->entries[--cache->count];
+        evicted = 1;
+        i--;
+    }
+    if (evicted)
+        sim_retain_rebuild();
+}
+
+// Non-negative floats compare the same as their bit patterns, so the top
+// 24 bits make a monotonic quantised depth.
+static uint64_t depth_bits(float depth) {
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    bits.f = depth > 0.f ? depth : 0.f;
+    return bits.u >> 8;
+}
+
+// Sort keys, most significant first:
+//   opaque:      layer:8 | 0:1 | pipeline:15 | texture:16 | depth:24 (front to back)
+//   transparent: layer:8 | 1:1 | ~depth:24 (back to front) | pipeline:15 | texture:16
+// Depth is the view space distance of the batch's first vertex (or the
+// origin for stored buffers) under its first instance's modelview.
+static uint64_t sim_sort_key(const sim_recorder_t *rec, sim_draw_call_t *call) {
+    sim_vs_inst_t *inst = (sim_vs_inst_t*)(rec->instances.data + call->ioffset);
+    hmm_vec4 position = HMM_Vec4(0.f, 0.f, 0.f, 1.f);
+    if (call->vstream && call->vcount) {
+        float *p = (float*)(rec->vertices.data + call->voffset);
+        position = HMM_Vec4(p[0], p[1], sim.formats[call->format].position_size > 2 ? p[2] : 0.f, 1.f);
+    }
+    float depth = -HMM_DotVec4(inst->z, position);
+    uint64_t pip = call->pip.id & 0x7FFF;
+    uint64_t texture = call->bind.fs.images[SLOT_texture_v].id & 0xFFFF;
+    uint64_t key = (uint64_t)call->state.layer << 56;
+    if (call->state.blend.enabled)
+        key |= 1ULL << 55 | (~depth_bits(depth) & 0xFFFFFF) << 31 | pip << 16 | texture;
+    else
+        key |= pip << 40 | texture << 24 | depth_bits(depth);
+    return key;
+}
+
+static void sim_append_stream(sim_stream_t *dst, const sim_stream_t *src) {
+    if (!src->size)
+        return;
+    memcpy(sim_stream_reserve(dst, src->size), src->data, src->size);
+    dst->size += src->size;
+}
+
+// Vertices in a recorder's stream, each one is owned by exactly one
+// streamed draw or by the batch still being recorded
+static int sim_stream_vertex_count(const sim_recorder_t *rec) {
+    int result = 0;
+    for (int i = 0; i < rec->commands.count; i++) {
+        const sim_command_t *command = &rec->commands.commands[i];
+        if (command->type == SIM_CMD_DRAW_CALL && command->draw_call.vstream)
+            result += command->draw_call.vcount;
+    }
+    if (rec->state.in_batch && !rec->state.current_buffer)
+        result += rec->state.draw_call.vcount;
+    return result;
+}
+
+static void sim_update_vertex_high_water(sim_recorder_t *rec) {
+    int count = sim_stream_vertex_count(rec);
+    if (count > rec->vertex_high_water)
+        rec->vertex_high_water = count;
+}
+
+// Looks up the pipeline and sampler of a draw that deferred them, see
+// sim_recording_on_main_thread()
+static void sim_resolve_draw_call(sim_draw_call_t *call) {
+    if (call->pip.id)
+        return;
+    call->pip = sim_find_pipeline(call, &call->keep_pip);
+    call->bind.fs.samplers[SLOT_sampler_v] = sim_find_sampler(call, &call->keep_smp);
+}
+
+// Appends a recorder's commands and stream data to dst, rebasing their
+// offsets. Only when merging into the main recorder are the pipelines,
+// samplers and sort keys the draws deferred resolved.
+static void sim_merge_recorder(sim_context_t *ctx, sim_recorder_t *dst, sim_recorder_t *src) {
+    if (!src->commands.count)
+        return;
+    sim_update_vertex_high_water(src);
+    int voffset = dst->vertices.size;
+    int ioffset = dst->instances.size;
+    int index_offset = dst->indices.size;
+    sim_append_stream(&dst->vertices, &src->vertices);
+    sim_append_stream(&dst->instances, &src->instances);
+    sim_append_stream(&dst->indices, &src->indices);
+    for (int i = 0; i < src->commands.count; i++) {
+        sim_command_t *command = sim_queue_push(&dst->commands, src->commands.commands[i].type);
+        memcpy(command, &src->commands.commands[i], sizeof(sim_command_t));
+        if (command->type != SIM_CMD_DRAW_CALL)
+            continue;
+        sim_draw_call_t *call = &command->draw_call;
+        call->voffset += voffset;
+        call->ioffset += ioffset;
+        call->index_offset += index_offset;
+        if (dst != &ctx->main)
+            continue;
+        sim_resolve_draw_call(call);
+        if (ctx->draw_order == SIM_DRAW_ORDER_SORTED)
+            call->sort_key = sim_sort_key(dst, call);
+    }
+    src->commands.count = 0;
+    src->vertices.size = 0;
+    src->instances.size = 0;
+    src->indices.size = 0;
+}
+
+// Merges every worker recorder in handle order, so the result doesn't
+// depend on which thread finished first.
+static void sim_merge_recorders(sim_context_t *ctx, sim_recorder_t *dst) {
+    for (int i = 0; i < ctx->recorder_count; i++) {
+        assert(!ctx->recorders[i]->bound);
+        sim_merge_recorder(ctx, dst, ctx->recorders[i]);
+    }
+}
+
+// Atlas pages are edited on the CPU and uploaded at most once per frame,
+// which is all a dynamic image allows anyway.
+static void sim_upload_atlases(void) {
+    for (int i = 0; i < sim.atlas_count; i++) {
+        sim_atlas_t *atlas = &sim.atlases[i];
+        for (int j = 0; j < atlas->page_count; j++) {
+            sim_atlas_page_t *page = &atlas->pages[j];
+            if (!page->dirty || page->uploaded == sim.commit_count + 1)
+                continue;
+            sim_update_image(page->image, &(sg_image_data) {
+                .subimage[0][0] = (sg_range) {
+                    .ptr = page->pixels,
+                    .size = atlas->width * atlas->height * sizeof(int)
+                }
+            });
+            page->dirty = 0;
+            page->uploaded = sim.commit_count + 1;
+        }
+    }
+}
+
+static void sim_destroy_list(sim_list_t *list) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->commands[i].type != SIM_CMD_DRAW_CALL)
+            continue;
+        sim_draw_call_t *call = &list->commands[i].draw_call;
+        if (call->keep_pip)
+            sim_pin_pipeline(call->pip, -1);
+        else
+            sim_destroy_pipeline(call->pip);
+        if (!call->keep_smp)
+            sim_destroy_sampler(call->bind.fs.samplers[SLOT_sampler_v]);
+    }
+    sim_soft_forget(&sim.soft.buffers, list->vbuf.id);
+    sim_soft_forget(&sim.soft.buffers, list->ibuf.id);
+    if (list->vbuf.id != SG_INVALID_ID)
+        sim_destroy_buffer(list->vbuf);
+    if (list->ibuf.id != SG_INVALID_ID)
+        sim_destroy_buffer(list->ibuf);
+    free(list->commands);
+    free(list->instances);
+}
+
+// Destroys released lists no queued command can call anymore, or all of
+// them. Commands calling a list were recorded before it was released, so
+// they are gone once every context has submitted since.
+static void sim_collect_lists(int all) {
+    uint64_t epoch = sim_pipeline_epoch();
+    for (int i = 0; i < sim.released_list_count; i++) {
+        if (!all && sim.released_lists[i].released >= epoch)
+            continue;
+        sim_destroy_list(&sim.released_lists[i]);
+        sim.released_lists[i--] = sim.released_lists[--sim.released_list_count];
+    }
+}
+
+#if defined(SIM_THREADS)
+static void sim_yield(void) {
+#if defined(SIM_WINDOWS)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+#if defined(SIM_WINDOWS)
+static DWORD WINAPI sim_pipeline_thread(LPVOID arg) {
+#else
+static void* sim_pipeline_thread(void *arg) {
+#endif
+    (void)arg;
+    sim_pipeline_t *pipeline = &sim.pipeline;
+    for (;;) {
+        int slot;
+        while (!(slot = atomic_load(&pipeline->go)))
+            sim_yield();
+        if (slot < 0)
+            break;
+        atomic_store(&pipeline->go, 0);
+        sim_thread_recorder = &pipeline->recorders[slot-1];
+        uint64_t start = stm_now();
+        sim.loop(pipeline->t);
+        pipeline->loop_ms = stm_ms(stm_since(start));
+        sim_flush_sprites();
+        sim_merge_recorders(&sim.context, sim_thread_recorder);
+        sim_thread_recorder = NULL;
+        atomic_store(&pipeline->ready, slot);
+    }
+    return 0;
+}
+
+// Input seen by the frame about to be recorded, the same rollover a
+// synchronous frame does after submitting.
+static void sim_pipeline_snapshot_input(void) {
+    memcpy(&sim.last_input, &sim.current_input, sizeof(sim_input_t));
+    memcpy(&sim.current_input, &sim.pipeline.input, sizeof(sim_input_t));
+    memset(&sim.pipeline.input, 0, sizeof(sim_input_t));
+}
+
+static void sim_pipeline_kick(int slot, double t) {
+    sim_pipeline_t *pipeline = &sim.pipeline;
+    sim_pipeline_snapshot_input();
+    // immediate-mode state carries over from whichever frame was recorded last
+    pipeline->recorders[slot].state = pipeline->recorders[slot ^ 1].state;
+    pipeline->t = t;
+    pipeline->in_flight = 1;
+    atomic_store(&pipeline->go, slot + 1);
+}
+
+static int sim_pipeline_wait(void) {
+    sim_pipeline_t *pipeline = &sim.pipeline;
+    pipeline->in_flight = 0;
+    int slot;
+    while (!(slot = atomic_load(&pipeline->ready)))
+        sim_yield();
+    atomic_store(&pipeline->ready, 0);
+    return slot - 1;
+}
+
+// Collects the frame the loop thread just finished, starts it on the next
+// one and leaves the finished frame in the main recorder for submission.
+static void sim_pipeline_frame(double t) {
+    sim_pipeline_t *pipeline = &sim.pipeline;
+    if (!pipeline->started) {
+        pipeline->recorders[0].state = sim.context.main.state;
+        pipeline->recorders[1].state = sim.context.main.state;
+        atomic_store(&pipeline->go, 0);
+        atomic_store(&pipeline->ready, 0);
+#if defined(SIM_WINDOWS)
+        pipeline->thread = CreateThread(NULL, 0, sim_pipeline_thread, NULL, 0, NULL);
+        assert(pipeline->thread);
+#else
+        int result = pthread_create(&pipeline->thread, NULL, sim_pipeline_thread, NULL);
+        assert(!result);
+#endif
+        pipeline->started = 1;
+        sim_pipeline_kick(0, t);
+    }
+    int slot = sim_pipeline_wait();
+    // read before the next kick lets the loop thread overwrite it
+    sim.stats.loop_ms = pipeline->loop_ms;
+    sim_pipeline_kick(slot ^ 1, t);
+    sim_recorder_t *rec = &pipeline->recorders[slot];
+    sim_merge_recorder(&sim.context, &sim.context.main, rec);
+    sim.context.main.state.clear_color = rec->state.clear_color;
+}
+
+static void sim_pipeline_shutdown(void) {
+    sim_pipeline_t *pipeline = &sim.pipeline;
+    if (!pipeline->started)
+        return;
+    if (pipeline->in_flight)
+        sim_pipeline_wait();
+    atomic_store(&pipeline->go, -1);
+#if defined(SIM_WINDOWS)
+    WaitForSingleObject(pipeline->thread, INFINITE);
+    CloseHandle(pipeline->thread);
+#else
+    pthread_join(pipeline->thread, NULL);
+#endif
+    pipeline->started = 0;
+}
+#else
+// sim_set_pipelined() is a no-op without threads, so these never run
+static void sim_pipeline_frame(double t) {
+    (void)t;
+}
+
+static void sim_pipeline_shutdown(void) {}
+#endif // SIM_THREADS
+
+static sim_render_target_t* sim_get_render_target(int target) {
+    assert(target > 0 && target <= sim.target_count);
+    sim_render_target_t *result = &sim.targets[target-1];
+    assert(result->color.id != SG_INVALID_ID);
+    return result;
+}
+
+// Targets use the swapchain's formats and sample count, so every cached
+// pipeline works with them. Multisampled targets resolve into a separate
+// image which is the one exposed as a texture.
+int sim_render_target_create(int width, int height) {
+    assert(width > 0 && height > 0);
+    int result = 0;
+    for (int i = 0; i < sim.target_count; i++)
+        if (sim.targets[i].color.id == SG_INVALID_ID) {
+            result = i + 1;
+            break;
+        }
+    if (!result) {
+        sim.targets = realloc(sim.targets, ++sim.target_count * sizeof(sim_render_target_t));
+        assert(sim.targets);
+        result = sim.target_count;
+    }
+    sim_render_target_t *target = &sim.targets[result-1];
+    memset(target, 0, sizeof(sim_render_target_t));
+    target->width = width;
+    target->height = height;
+
+    sg_environment_defaults env = sg_query_desc().environment.defaults;
+    int sample_count = env.sample_count > 1 ? env.sample_count : 1;
+    target->color = sg_make_image(&(sg_image_desc) {
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = env.color_format,
+        .sample_count = sample_count
+    });
+    target->depth = sg_make_image(&(sg_image_desc) {
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = env.depth_format ? env.depth_format : SG_PIXELFORMAT_DEPTH_STENCIL,
+        .sample_count = sample_count
+    });
+    if (sample_count > 1)
+        target->resolve = sg_make_image(&(sg_image_desc) {
+            .render_target = true,
+            .width = width,
+            .height = height,
+            .pixel_format = env.color_format
+        });
+    target->attachments = sg_make_attachments(&(sg_attachments_desc) {
+        .colors[0].image = target->color,
+        .resolves[0].image = target->resolve,
+        .depth_stencil.image = target->depth
+    });
+    if (sim.soft.enabled) {
+        target->soft_color = calloc(width * height, 4);
+        target->soft_depth = malloc(width * height * sizeof(float));
+        assert(target->soft_color && target->soft_depth);
+        sim_soft_shadow(&sim.soft.images, target->resolve.id != SG_INVALID_ID ? target->resolve.id : target->color.id, target->soft_color, width * height * 4, width, height, 0);
+    }
+    return result;
+}
+
+int sim_render_target_texture(int target) {
+    sim_render_target_t *rt = sim_get_render_target(target);
+    return rt->resolve.id != SG_INVALID_ID ? rt->resolve.id : rt->color.id;
+}
+
+void sim_render_target_release(int target) {
+    sim_render_target_t *rt = sim_get_render_target(target);
+    sim_soft_forget(&sim.soft.images, sim_render_target_texture(target));
+    free(rt->soft_color);
+    free(rt->soft_depth);
+    sg_destroy_attachments(rt->attachments);
+    sg_destroy_image(rt->color);
+    sg_destroy_image(rt->depth);
+    if (rt->resolve.id != SG_INVALID_ID)
+        sg_destroy_image(rt->resolve);
+    memset(rt, 0, sizeof(sim_render_target_t));
+}
+
+static void sim_count_draw(const sim_draw_call_t *call) {
+    sim.stats.draws++;
+    sim.stats.instances += call->icount;
+    sim.stats.vertices += (call->index_count ? call->index_count : call->vcount) * call->icount;
+}
+
+static int sim_cpu_count(void) {
+#if defined(SIM_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(SIM_EMSCRIPTEN)
+    return 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static unsigned char unorm8(float v) {
+    v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+    return (unsigned char)(v * 255.f + .5f);
+}
+
+static int sim_soft_wrap(sg_wrap wrap, int i, int n) {
+    switch (wrap) {
+        case SG_WRAP_CLAMP_TO_EDGE:
+            return i < 0 ? 0 : i >= n ? n - 1 : i;
+        case SG_WRAP_CLAMP_TO_BORDER:
+            return i < 0 || i >= n ? -1 : i;
+        case SG_WRAP_MIRRORED_REPEAT:;
+            int m = ((i % (2 * n)) + 2 * n) % (2 * n);
+            return m < n ? m : 2 * n - 1 - m;
+        default:
+            return ((i % n) + n) % n;
+    }
+}
+
+static void sim_soft_texel(const sim_soft_draw_t *draw, int x, int y, float *out) {
+    x = sim_soft_wrap(draw->sampler.wrap_u, x, draw->tex_width);
+    y = sim_soft_wrap(draw->sampler.wrap_v, y, draw->tex_height);
+    if (x < 0 || y < 0) {
+        // sokol's default border colour
+        out[0] = out[1] = out[2] = 0.f;
+        out[3] = 1.f;
+        return;
+    }
+    const unsigned char *p = draw->texels + (y * draw->tex_width + x) * 4;
+    for (int i = 0; i < 4; i++)
+        out[i] = p[i] * (1.f / 255.f);
+}
+
+// There are no mipmaps, so the filter is the only thing minification
+// changes. It's decided once per triangle.
+static void sim_soft_sample(const sim_soft_draw_t *draw, float u, float v, int minify, float *out) {
+    if (!draw->texels) {
+        out[0] = out[1] = out[2] = out[3] = 1.f;
+        return;
+    }
+    if (!(fabsf(u) < 1e6f))
+        u = 0.f;
+    if (!(fabsf(v) < 1e6f))
+        v = 0.f;
+    float x = u * draw->tex_width, y = v * draw->tex_height;
+    if ((minify ? draw->sampler.min_filter : draw->sampler.mag_filter) != SG_FILTER_LINEAR) {
+        sim_soft_texel(draw, (int)floorf(x), (int)floorf(y), out);
+        return;
+    }
+    x -= .5f;
+    y -= .5f;
+    int x0 = (int)floorf(x), y0 = (int)floorf(y);
+    float fx = x - x0, fy = y - y0;
+    float t[4][4];
+    sim_soft_texel(draw, x0, y0, t[0]);
+    sim_soft_texel(draw, x0 + 1, y0, t[1]);
+    sim_soft_texel(draw, x0, y0 + 1, t[2]);
+    sim_soft_texel(draw, x0 + 1, y0 + 1, t[3]);
+    for (int i = 0; i < 4; i++) {
+        float top = t[0][i] + (t[1][i] - t[0][i]) * fx;
+        float bottom = t[2][i] + (t[3][i] - t[2][i]) * fx;
+        out[i] = top + (bottom - top) * fy;
+    }
+}
+
+static int sim_soft_depth_test(sg_compare_func func, float z, float depth) {
+    switch (func) {
+        case SG_COMPAREFUNC_NEVER:
+            return 0;
+        case SG_COMPAREFUNC_LESS:
+            return z < depth;
+        case SG_COMPAREFUNC_EQUAL:
+            return z == depth;
+        case SG_COMPAREFUNC_LESS_EQUAL:
+            return z <= depth;
+        case SG_COMPAREFUNC_GREATER:
+            return z > depth;
+        case SG_COMPAREFUNC_NOT_EQUAL:
+            return z != depth;
+        case SG_COMPAREFUNC_GREATER_EQUAL:
+            return z >= depth;
+        default:
+            return 1;
+    }
+}
+
+// The blend colour is never set, so it's sokol's default of zero
+static float sim_soft_blend_factor(sg_blend_factor factor, const float *src, const float *dst, int i, float fallback) {
+    switch (factor) {
+        case SG_BLENDFACTOR_ZERO:
+        case SG_BLENDFACTOR_BLEND_COLOR:
+        case SG_BLENDFACTOR_BLEND_ALPHA:
+            return 0.f;
+        case SG_BLENDFACTOR_ONE:
+        case SG_BLENDFACTOR_ONE_MINUS_BLEND_COLOR:
+        case SG_BLENDFACTOR_ONE_MINUS_BLEND_ALPHA:
+            return 1.f;
+        case SG_BLENDFACTOR_SRC_COLOR:
+            return src[i];
+        case SG_BLENDFACTOR_ONE_MINUS_SRC_COLOR:
+            return 1.f - src[i];
+        case SG_BLENDFACTOR_SRC_ALPHA:
+            return src[3];
+        case SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA:
+            return 1.f - src[3];
+        case SG_BLENDFACTOR_DST_COLOR:
+            return dst[i];
+        case SG_BLENDFACTOR_ONE_MINUS_DST_COLOR:
+            return 1.f - dst[i];
+        case SG_BLENDFACTOR_DST_ALPHA:
+            return dst[3];
+        case SG_BLENDFACTOR_ONE_MINUS_DST_ALPHA:
+            return 1.f - dst[3];
+        case SG_BLENDFACTOR_SRC_ALPHA_SATURATED:
+            return i == 3 ? 1.f : (src[3] < 1.f - dst[3] ? src[3] : 1.f - dst[3]);
+        default:
+            return fallback;
+    }
+}
+
+static float sim_soft_blend_op(sg_blend_op op, float src, float dst) {
+    switch (op) {
+        case SG_BLENDOP_SUBTRACT:
+            return src - dst;
+        case SG_BLENDOP_REVERSE_SUBTRACT:
+            return dst - src;
+        default:
+            return src + dst;
+    }
+}
+
+// What fs does for one pixel, followed by the depth test and blending
+static void sim_soft_shade(const sim_soft_triangle_t *tri, const sim_soft_draw_t *draw, int x, int y, float e0, float e1, float e2) {
+    sim_soft_t *soft = &sim.soft;
+    float l0 = e0 * tri->inv_area, l1 = e1 * tri->inv_area, l2 = e2 * tri->inv_area;
+    int index = y * soft->width + x;
+    float z = l0 * tri->z[0] + l1 * tri->z[1] + l2 * tri->z[2];
+    if (!sim_soft_depth_test(draw->depth_compare, z, soft->depth[index]))
+        return;
+    float w = 1.f / (l0 * tri->w[0] + l1 * tri->w[1] + l2 * tri->w[2]);
+    float u = (l0 * tri->u[0] + l1 * tri->u[1] + l2 * tri->u[2]) * w;
+    float v = (l0 * tri->v[0] + l1 * tri->v[1] + l2 * tri->v[2]) * w;
+    float src[4];
+    sim_soft_sample(draw, u, v, tri->minify, src);
+    for (int i = 0; i < 4; i++) {
+        float c = (l0 * tri->color[0].Elements[i] + l1 * tri->color[1].Elements[i] + l2 * tri->color[2].Elements[i]) * w;
+        // unorm targets clamp the fragment colour before blending
+        c *= src[i];
+        src[i] = c < 0.f ? 0.f : c > 1.f ? 1.f : c;
+    }
+    unsigned char *out = soft->color + index * 4;
+    if (draw->blend.enabled) {
+        float dst[4], result[4];
+        for (int i = 0; i < 4; i++)
+            dst[i] = out[i] * (1.f / 255.f);
+        for (int i = 0; i < 4; i++) {
+            const sg_blend_state *b = &draw->blend;
+            sg_blend_factor sf = i < 3 ? b->src_factor_rgb : b->src_factor_alpha;
+            sg_blend_factor df = i < 3 ? b->dst_factor_rgb : b->dst_factor_alpha;
+            result[i] = sim_soft_blend_op(i < 3 ? b->op_rgb : b->op_alpha,
+                                          src[i] * sim_soft_blend_factor(sf, src, dst, i, 1.f),
+                                          dst[i] * sim_soft_blend_factor(df, src, dst, i, 0.f));
+        }
+        for (int i = 0; i < 4; i++)
+            out[i] = unorm8(result[i]);
+    } else
+        for (int i = 0; i < 4; i++)
+            out[i] = unorm8(src[i]);
+    if (draw->depth_write)
+        soft->depth[index] = z;
+}
+
+// Coverage is tested four pixels at a time, covered pixels are shaded one
+// by one. Edges on the triangle's top-left side own the pixels exactly on
+// them so shared edges are drawn once.
+static void sim_soft_raster(const sim_soft_triangle_t *tri, int x0, int y0, int x1, int y1) {
+    const sim_soft_draw_t *draw = &sim.soft.draws[tri->draw];
+    for (int y = y0; y < y1; y++) {
+        float py = y + .5f;
+        float row[3];
+        for (int i = 0; i < 3; i++)
+            row[i] = tri->b[i] * py + tri->c[i];
+#if defined(SIM_SSE)
+        const __m128 steps = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (int x = x0; x < x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), steps);
+            __m128 e[3];
+            int mask = x1 - x >= 4 ? 0xF : (1 << (x1 - x)) - 1;
+            for (int i = 0; i < 3; i++) {
+                e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->a[i]), px), _mm_set1_ps(row[i]));
+                mask &= _mm_movemask_ps(tri->top_left[i] ? _mm_cmpge_ps(e[i], zero) : _mm_cmpgt_ps(e[i], zero));
+            }
+            if (!mask)
+                continue;
+            float e0[4], e1[4], e2[4];
+            _mm_storeu_ps(e0, e[0]);
+            _mm_storeu_ps(e1, e[1]);
+            _mm_storeu_ps(e2, e[2]);
+            for (int lane = 0; lane < 4; lane++)
+                if (mask & (1 << lane))
+                    sim_soft_shade(tri, draw, x + lane, y, e0[lane], e1[lane], e2[lane]);
+        }
+#else
+        for (int x = x0; x < x1; x++) {
+            float px = x + .5f;
+            float e[3];
+            int inside = 1;
+            for (int i = 0; i < 3; i++) {
+                e[i] = tri->a[i] * px + row[i];
+                inside &= tri->top_left[i] ? e[i] >= 0.f : e[i] > 0.f;
+            }
+            if (inside)
+                sim_soft_shade(tri, draw, x, y, e[0], e[1], e[2]);
+        }
+#endif
+    }
+}
+
+static void sim_soft_raster_tile(int tile) {
+    sim_soft_t *soft = &sim.soft;
+    int x0 = (tile % soft->tiles_x) * SOFT_TILE_SIZE;
+    int y0 = (tile / soft->tiles_x) * SOFT_TILE_SIZE;
+    int x1 = x0 + SOFT_TILE_SIZE < soft->width ? x0 + SOFT_TILE_SIZE : soft->width;
+    int y1 = y0 + SOFT_TILE_SIZE < soft->height ? y0 + SOFT_TILE_SIZE : soft->height;
+    if (soft->clear)
+        for (int y = y0; y < y1; y++)
+            for (int x = x0; x < x1; x++) {
+                memcpy(soft->color + (y * soft->width + x) * 4, soft->clear_color, 4);
+                soft->depth[y * soft->width + x] = 1.f;
+            }
+    sim_soft_bin_t *bin = &soft->bins[tile];
+    for (int i = 0; i < bin->count; i++) {
+        const sim_soft_triangle_t *tri = &soft->triangles[bin->items[i]];
+        sim_soft_raster(tri,
+                        tri->minx > x0 ? tri->minx : x0,
+                        tri->miny > y0 ? tri->miny : y0,
+                        tri->maxx < x1 ? tri->maxx : x1,
+                        tri->maxy < y1 ? tri->maxy : y1);
+    }
+}
+
+static void sim_soft_run_tiles(void) {
+    sim_soft_t *soft = &sim.soft;
+    int count = soft->tiles_x * soft->tiles_y;
+#if defined(SIM_THREADS)
+    int tile;
+    while ((tile = atomic_fetch_add(&soft->next_tile, 1)) < count) {
+        sim_soft_raster_tile(tile);
+        atomic_fetch_add(&soft->done, 1);
+    }
+#else
+    for (int tile = 0; tile < count; tile++)
+        sim_soft_raster_tile(tile);
+#endif
+}
+
+#if defined(SIM_THREADS)
+static void sim_soft_lock(sim_soft_t *soft) {
+#if defined(SIM_WINDOWS)
+    EnterCriticalSection(&soft->lock);
+#else
+    pthread_mutex_lock(&soft->lock);
+#endif
+}
+
+static void sim_soft_unlock(sim_soft_t *soft) {
+#if defined(SIM_WINDOWS)
+    LeaveCriticalSection(&soft->lock);
+#else
+    pthread_mutex_unlock(&soft->lock);
+#endif
+}
+
+// Changes generation or quit under the lock so no worker misses the wakeup
+// between checking them and going to sleep
+static void sim_soft_wake(sim_soft_t *soft, _Atomic int *value, int delta) {
+    sim_soft_lock(soft);
+    atomic_fetch_add(value, delta);
+#if defined(SIM_WINDOWS)
+    WakeAllConditionVariable(&soft->wake);
+#else
+    pthread_cond_broadcast(&soft->wake);
+#endif
+    sim_soft_unlock(soft);
+}
+
+#if defined(SIM_WINDOWS)
+static DWORD WINAPI sim_soft_thread(LPVOID arg) {
+#else
+static void* sim_soft_thread(void *arg) {
+#endif
+    (void)arg;
+    sim_soft_t *soft = &sim.soft;
+    int seen = 0;
+    for (;;) {
+        int generation;
+        sim_soft_lock(soft);
+        while ((generation = atomic_load(&soft->generation)) == seen && !atomic_load(&soft->quit))
+#if defined(SIM_WINDOWS)
+            SleepConditionVariableCS(&soft->wake, &soft->lock, INFINITE);
+#else
+            pthread_cond_wait(&soft->wake, &soft->lock);
+#endif
+        sim_soft_unlock(soft);
+        if (atomic_load(&soft->quit))
+            break;
+        seen = generation;
+        sim_soft_run_tiles();
+    }
+    return 0;
+}
+#endif
+
+// Rasterizes everything binned so far. Only the draw being set up, which
+// is always the last one, survives.
+static void sim_soft_flush(void) {
+    sim_soft_t *soft = &sim.soft;
+#if defined(SIM_THREADS)
+    if (soft->thread_count > 1 && !soft->started) {
+        atomic_store(&soft->quit, 0);
+        atomic_store(&soft->generation, 0);
+        atomic_store(&soft->next_tile, INT_MAX / 2);
+#if defined(SIM_WINDOWS)
+        InitializeCriticalSection(&soft->lock);
+        InitializeConditionVariable(&soft->wake);
+#else
+        pthread_mutex_init(&soft->lock, NULL);
+        pthread_cond_init(&soft->wake, NULL);
+#endif
+        for (int i = 0; i < soft->thread_count - 1; i++) {
+#if defined(SIM_WINDOWS)
+            soft->threads[i] = CreateThread(NULL, 0, sim_soft_thread, NULL, 0, NULL);
+            assert(soft->threads[i]);
+#else
+            int result = pthread_create(&soft->threads[i], NULL, sim_soft_thread, NULL);
+            assert(!result);
+#endif
+        }
+        soft->started = 1;
+    }
+    // bins are complete before next_tile lets anyone at them
+    atomic_store(&soft->done, 0);
+    atomic_store(&soft->next_tile, 0);
+    if (soft->started)
+        sim_soft_wake(soft, &soft->generation, 1);
+    sim_soft_run_tiles();
+    while (atomic_load(&soft->done) < soft->tiles_x * soft->tiles_y)
+        sim_yield();
+    atomic_store(&soft->next_tile, INT_MAX / 2);
+#else
+    sim_soft_run_tiles();
+#endif
+    soft->clear = 0;
+    for (int i = 0; i < soft->tiles_x * soft->tiles_y; i++)
+        soft->bins[i].count = 0;
+    soft->triangle_count = 0;
+    if (soft->draw_count) {
+        soft->draws[0] = soft->draws[soft->draw_count-1];
+        soft->draw_count = 1;
+    }
+}
+
+static void sim_soft_shutdown(void) {
+    sim_soft_t *soft = &sim.soft;
+#if defined(SIM_THREADS)
+    if (soft->started) {
+        sim_soft_wake(soft, &soft->quit, 1);
+        for (int i = 0; i < soft->thread_count - 1; i++) {
+#if defined(SIM_WINDOWS)
+            WaitForSingleObject(soft->threads[i], INFINITE);
+            CloseHandle(soft->threads[i]);
+#else
+            pthread_join(soft->threads[i], NULL);
+#endif
+        }
+#if defined(SIM_WINDOWS)
+        DeleteCriticalSection(&soft->lock);
+#else
+        pthread_mutex_destroy(&soft->lock);
+        pthread_cond_destroy(&soft->wake);
+#endif
+        soft->started = 0;
+    }
+#endif
+    for (int i = 0; i < soft->buffers.count; i++)
+        if (soft->buffers.entries[i].owned)
+            free(soft->buffers.entries[i].data);
+    for (int i = 0; i < soft->images.count; i++)
+        if (soft->images.entries[i].owned)
+            free(soft->images.entries[i].data);
+    soft->buffers.count = 0;
+    soft->images.count = 0;
+}
+
+static void sim_soft_setup(const sim_soft_vertex_t *v0, const sim_soft_vertex_t *v1, const sim_soft_vertex_t *v2, sg_cull_mode cull) {
+    sim_soft_t *soft = &sim.soft;
+    float area = (v1->position.X - v0->position.X) * (v2->position.Y - v0->position.Y) -
+                 (v2->position.X - v0->position.X) * (v1->position.Y - v0->position.Y);
+    if (!(area != 0.f))
+        return;
+    // clockwise is front facing, sokol's default winding
+    if ((cull == SG_CULLMODE_BACK && area > 0.f) || (cull == SG_CULLMODE_FRONT && area < 0.f))
+        return;
+    if (area < 0.f) {
+        const sim_soft_vertex_t *tmp = v1;
+        v1 = v2;
+        v2 = tmp;
+        area = -area;
+    }
+    const sim_soft_draw_t *draw = &soft->draws[soft->draw_count-1];
+    const sim_soft_vertex_t *v[3] = {v0, v1, v2};
+    float minx = v0->position.X, maxx = minx, miny = v0->position.Y, maxy = miny;
+    for (int i = 1; i < 3; i++) {
+        minx = v[i]->position.X < minx ? v[i]->position.X : minx;
+        maxx = v[i]->position.X > maxx ? v[i]->position.X : maxx;
+        miny = v[i]->position.Y < miny ? v[i]->position.Y : miny;
+        maxy = v[i]->position.Y > maxy ? v[i]->position.Y : maxy;
+    }
+    int x0 = (int)floorf(minx), x1 = (int)ceilf(maxx);
+    int y0 = (int)floorf(miny), y1 = (int)ceilf(maxy);
+    x0 = x0 > draw->minx ? x0 : draw->minx;
+    y0 = y0 > draw->miny ? y0 : draw->miny;
+    x1 = x1 < draw->maxx ? x1 : draw->maxx;
+    y1 = y1 < draw->maxy ? y1 : draw->maxy;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    if (soft->triangle_count == MAX_SOFT_TRIANGLES)
+        sim_soft_flush();
+    int index = soft->triangle_count++;
+    sim_soft_triangle_t *tri = &soft->triangles[index];
+    for (int i = 0; i < 3; i++) {
+        const sim_soft_vertex_t *a = v[(i + 1) % 3], *b = v[(i + 2) % 3];
+        tri->a[i] = a->position.Y - b->position.Y;
+        tri->b[i] = b->position.X - a->position.X;
+        tri->c[i] = -(tri->a[i] * a->position.X + tri->b[i] * a->position.Y);
+        tri->top_left[i] = tri->a[i] > 0.f || (tri->a[i] == 0.f && tri->b[i] > 0.f);
+        tri->z[i] = v[i]->position.Z;
+        tri->w[i] = v[i]->position.W;
+        tri->u[i] = v[i]->u;
+        tri->v[i] = v[i]->v;
+        tri->color[i] = v[i]->color;
+    }
+    tri->inv_area = 1.f / area;
+    tri->minx = x0;
+    tri->miny = y0;
+    tri->maxx = x1;
+    tri->maxy = y1;
+    tri->draw = soft->draw_count - 1;
+    tri->minify = 0;
+    if (draw->texels) {
+        // texels per pixel from the affine texcoord gradients
+        float dudx = 0.f, dudy = 0.f, dvdx = 0.f, dvdy = 0.f;
+        for (int i = 0; i < 3; i++) {
+            float u = tri->u[i] / tri->w[i], v = tri->v[i] / tri->w[i];
+            dudx += tri->a[i] * u;
+            dudy += tri->b[i] * u;
+            dvdx += tri->a[i] * v;
+            dvdy += tri->b[i] * v;
+        }
+        float scale = tri->inv_area * tri->inv_area * draw->tex_width * draw->tex_height;
+        tri->minify = fabsf(dudx * dvdy - dudy * dvdx) * scale > 1.f;
+    }
+
+    for (int ty = y0 / SOFT_TILE_SIZE; ty <= (y1 - 1) / SOFT_TILE_SIZE; ty++)
+        for (int tx = x0 / SOFT_TILE_SIZE; tx <= (x1 - 1) / SOFT_TILE_SIZE; tx++) {
+            sim_soft_bin_t *bin = &soft->bins[ty * soft->tiles_x + tx];
+            if (bin->count == bin->capacity) {
+                bin->capacity = bin->capacity ? bin->capacity * 2 : 256;
+                bin->items = realloc(bin->items, bin->capacity * sizeof(int));
+                assert(bin->items);
+            }
+            bin->items[bin->count++] = index;
+        }
+}
+
+static sim_soft_vertex_t sim_soft_lerp(const sim_soft_vertex_t *a, const sim_soft_vertex_t *b, float t) {
+    sim_soft_vertex_t result;
+    result.position = HMM_AddVec4(a->position, HMM_MultiplyVec4f(HMM_SubtractVec4(b->position, a->position), t));
+    result.u = a->u + (b->u - a->u) * t;
+    result.v = a->v + (b->v - a->v) * t;
+    result.color = HMM_AddVec4(a->color, HMM_MultiplyVec4f(HMM_SubtractVec4(b->color, a->color), t));
+    return result;
+}
+
+// Near and far planes plus a guard band well outside the viewport that
+// keeps window coordinates small enough for float edge functions
+#define SOFT_CLIP_PLANES 6
+#define SOFT_GUARD_BAND 8.f
+
+static float sim_soft_clip_distance(const sim_soft_vertex_t *v, int plane) {
+    const hmm_vec4 p = v->position;
+    switch (plane) {
+        case 0:
+            return p.Z + p.W;
+        case 1:
+            return p.W - p.Z;
+        case 2:
+            return SOFT_GUARD_BAND * p.W - p.X;
+        case 3:
+            return SOFT_GUARD_BAND * p.W + p.X;
+        case 4:
+            return SOFT_GUARD_BAND * p.W - p.Y;
+        default:
+            return SOFT_GUARD_BAND * p.W + p.Y;
+    }
+}
+
+// Clip space to window coordinates. Viewports are recorded with a top-left
+// origin and converted to GL's bottom-left one when they're applied.
+static void sim_soft_project(sim_soft_vertex_t *v, const sim_soft_draw_t *draw) {
+    float w = 1.f / v->position.W;
+    v->position = HMM_Vec4(draw->viewport[0] + (v->position.X * w * .5f + .5f) * draw->viewport[2],
+                           draw->viewport[1] + (v->position.Y * w * .5f + .5f) * draw->viewport[3],
+                           v->position.Z * w * .5f + .5f,
+                           w);
+    v->u *= w;
+    v->v *= w;
+    v->color = HMM_MultiplyVec4f(v->color, w);
+}
+
+static void sim_soft_triangle(const sim_soft_vertex_t *a, const sim_soft_vertex_t *b, const sim_soft_vertex_t *c, sg_cull_mode cull) {
+    const sim_soft_draw_t *draw = &sim.soft.draws[sim.soft.draw_count-1];
+    sim_soft_vertex_t buffers[2][3 + SOFT_CLIP_PLANES];
+    sim_soft_vertex_t *in = buffers[0], *out = buffers[1];
+    in[0] = *a;
+    in[1] = *b;
+    in[2] = *c;
+    int count = 3;
+    for (int plane = 0; plane < SOFT_CLIP_PLANES; plane++) {
+        float d0 = sim_soft_clip_distance(&in[0], plane);
+        int inside = d0 >= 0.f, all = inside;
+        for (int i = 1; i < count; i++) {
+            int ok = sim_soft_clip_distance(&in[i], plane) >= 0.f;
+            inside |= ok;
+            all &= ok;
+        }
+        if (!inside)
+            return;
+        if (all)
+            continue;
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            const sim_soft_vertex_t *p = &in[i], *q = &in[(i + 1) % count];
+            float dp = sim_soft_clip_distance(p, plane), dq = sim_soft_clip_distance(q, plane);
+            if (dp >= 0.f)
+                out[n++] = *p;
+            if ((dp >= 0.f) != (dq >= 0.f))
+                out[n++] = sim_soft_lerp(p, q, dp / (dp - dq));
+        }
+        sim_soft_vertex_t *tmp = in;
+        in = out;
+        out = tmp;
+        count = n;
+    }
+    for (int i = 0; i < count; i++)
+        sim_soft_project(&in[i], draw);
+    for (int i = 1; i + 1 < count; i++)
+        sim_soft_setup(&in[0], &in[i], &in[i+1], cull);
+}
+
+// Lines and points become screen-space quads, one pixel wide or across
+static void sim_soft_quad(const sim_soft_vertex_t *a, const sim_soft_vertex_t *b, float nx, float ny) {
+    sim_soft_vertex_t q[4] = {*a, *a, *b, *b};
+    q[0].position.X += nx;
+    q[0].position.Y += ny;
+    q[1].position.X -= nx;
+    q[1].position.Y -= ny;
+    q[2].position.X -= nx;
+    q[2].position.Y -= ny;
+    q[3].position.X += nx;
+    q[3].position.Y += ny;
+    sim_soft_setup(&q[0], &q[1], &q[2], SG_CULLMODE_NONE);
+    sim_soft_setup(&q[0], &q[2], &q[3], SG_CULLMODE_NONE);
+}
+
+static void sim_soft_line(const sim_soft_vertex_t *a, const sim_soft_vertex_t *b) {
+    const sim_soft_draw_t *draw = &sim.soft.draws[sim.soft.draw_count-1];
+    sim_soft_vertex_t p = *a, q = *b;
+    for (int plane = 0; plane < SOFT_CLIP_PLANES; plane++) {
+        float dp = sim_soft_clip_distance(&p, plane), dq = sim_soft_clip_distance(&q, plane);
+        if (dp < 0.f && dq < 0.f)
+            return;
+        if (dp < 0.f)
+            p = sim_soft_lerp(&p, &q, dp / (dp - dq));
+        else if (dq < 0.f)
+            q = sim_soft_lerp(&p, &q, dp / (dp - dq));
+    }
+    sim_soft_project(&p, draw);
+    sim_soft_project(&q, draw);
+    float dx = q.position.X - p.position.X, dy = q.position.Y - p.position.Y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length < 1e-6f)
+        return;
+    sim_soft_quad(&p, &q, -dy / length * .5f, dx / length * .5f);
+}
+
+static void sim_soft_point(const sim_soft_vertex_t *a) {
+    sim_soft_vertex_t p = *a;
+    for (int plane = 0; plane < SOFT_CLIP_PLANES; plane++)
+        if (sim_soft_clip_distance(&p, plane) < 0.f)
+            return;
+    sim_soft_project(&p, &sim.soft.draws[sim.soft.draw_count-1]);
+    sim_soft_vertex_t q = p;
+    p.position.X -= .5f;
+    q.position.X += .5f;
+    sim_soft_quad(&p, &q, 0.f, .5f);
+}
+
+static int sim_soft_index(const unsigned char *indices, sg_index_type type, int i) {
+    if (!indices)
+        return i;
+    return type == SG_INDEXTYPE_UINT32 ? (int)((const uint32_t*)indices)[i] : ((const uint16_t*)indices)[i];
+}
+
+// What vs does: every vertex is transformed once per instance by the
+// projection times the instance's modelview, then primitives are assembled
+// from the transformed copies.
+static void sim_soft_draw(sim_context_t *ctx, const sim_draw_call_t *call, const float *viewport, const int *scissor) {
+    sim_soft_t *soft = &sim.soft;
+    const unsigned char *vertices = NULL, *indices = NULL;
+    if (call->vstream)
+        vertices = ctx->main.vertices.data + call->voffset;
+    else {
+        sim_soft_shadow_t *shadow = sim_soft_find(&soft->buffers, call->bind.vertex_buffers[0].id);
+        if (!shadow)
+            return;
+        vertices = shadow->data + call->bind.vertex_buffer_offsets[0];
+    }
+    sg_index_type index_type = call->state.index_type;
+    if (index_type == SG_INDEXTYPE_UINT16 || index_type == SG_INDEXTYPE_UINT32) {
+        if (call->index_stream)
+            indices = ctx->main.indices.data + call->index_offset;
+        else {
+            sim_soft_shadow_t *shadow = sim_soft_find(&soft->buffers, call->bind.index_buffer.id);
+            if (!shadow)
+                return;
+            indices = shadow->data + call->bind.index_buffer_offset;
+        }
+    }
+
+    if (soft->draw_count == soft->draw_capacity) {
+        soft->draw_capacity = soft->draw_capacity ? soft->draw_capacity * 2 : 64;
+        soft->draws = realloc(soft->draws, soft->draw_capacity * sizeof(sim_soft_draw_t));
+        assert(soft->draws);
+    }
+    sim_soft_draw_t *draw = &soft->draws[soft->draw_count];
+    memset(draw, 0, sizeof(sim_soft_draw_t));
+    memcpy(draw->viewport, viewport, sizeof(draw->viewport));
+    draw->minx = scissor[0] > 0 ? scissor[0] : 0;
+    draw->miny = scissor[1] > 0 ? scissor[1] : 0;
+    draw->maxx = scissor[0] + scissor[2] < soft->width ? scissor[0] + scissor[2] : soft->width;
+    draw->maxy = scissor[1] + scissor[3] < soft->height ? scissor[1] + scissor[3] : soft->height;
+    if (draw->minx >= draw->maxx || draw->miny >= draw->maxy)
+        return;
+    sim_soft_shadow_t *texture = sim_soft_find(&soft->images, call->bind.fs.images[SLOT_texture_v].id);
+    if (texture && texture->width && texture->height) {
+        draw->texels = texture->data;
+        draw->tex_width = texture->width;
+        draw->tex_height = texture->height;
+    }
+    draw->sampler = call->state.sampler;
+    draw->blend = call->state.blend;
+    draw->depth_compare = call->state.depth.compare;
+    draw->depth_write = call->state.depth.write_enabled;
+    soft->draw_count++;
+
+    int vcount = call->vcount;
+    if (vcount > soft->vertex_capacity) {
+        soft->vertex_capacity = next_pow2(vcount);
+        soft->vertices = realloc(soft->vertices, soft->vertex_capacity * sizeof(sim_soft_vertex_t));
+        soft->transformed = realloc(soft->transformed, soft->vertex_capacity * sizeof(sim_soft_vertex_t));
+        assert(soft->vertices && soft->transformed);
+    }
+    int stride = sim.formats[call->format].stride;
+    for (int i = 0; i < vcount; i++) {
+        sim_vertex_t vertex;
+        sim_unpack_vertex(call->format, vertices + i * stride, &vertex);
+        hmm_vec4 uv = HMM_MultiplyMat4ByVec4(call->texture_matrix, HMM_Vec4(vertex.texcoord.X, vertex.texcoord.Y, 0.f, 1.f));
+        soft->vertices[i].position = vertex.position;
+        soft->vertices[i].u = uv.X;
+        soft->vertices[i].v = uv.Y;
+        soft->vertices[i].color = vertex.color;
+    }
+
+    int count = indices ? call->index_count : vcount;
+    sg_cull_mode cull = call->state.cull_mode;
+    const sim_vs_inst_t *instances = (const sim_vs_inst_t*)(ctx->main.instances.data + call->ioffset);
+    for (int instance = 0; instance < call->icount; instance++) {
+        // the rows of the instance's modelview, as vs_common's make_matrix reads them
+        const hmm_vec4 *rows = &instances[instance].x;
+        hmm_mat4 modelview;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                modelview.Elements[c][r] = rows[r].Elements[c];
+        hmm_mat4 mvp = HMM_MultiplyMat4(call->projection, modelview);
+        for (int i = 0; i < vcount; i++) {
+            soft->transformed[i] = soft->vertices[i];
+            soft->transformed[i].position = HMM_MultiplyMat4ByVec4(mvp, soft->vertices[i].position);
+        }
+        const sim_soft_vertex_t *v = soft->transformed;
+#define SOFT_VERTEX(K) (sim_soft_index(indices, index_type, (K)) < vcount ? &v[sim_soft_index(indices, index_type, (K))] : NULL)
+        switch (call->state.primitive_type) {
+            case SG_PRIMITIVETYPE_POINTS:
+                for (int k = 0; k < count; k++) {
+                    const sim_soft_vertex_t *a = SOFT_VERTEX(k);
+                    if (a)
+                        sim_soft_point(a);
+                }
+                break;
+            case SG_PRIMITIVETYPE_LINES:
+            case SG_PRIMITIVETYPE_LINE_STRIP:;
+                int line_step = call->state.primitive_type == SG_PRIMITIVETYPE_LINES ? 2 : 1;
+                for (int k = 0; k + 1 < count; k += line_step) {
+                    const sim_soft_vertex_t *a = SOFT_VERTEX(k), *b = SOFT_VERTEX(k + 1);
+                    if (a && b)
+                        sim_soft_line(a, b);
+                }
+                break;
+            case SG_PRIMITIVETYPE_TRIANGLE_STRIP:
+                for (int k = 0; k + 2 < count; k++) {
+                    // every other triangle is flipped back to the strip's winding
+                    const sim_soft_vertex_t *a = SOFT_VERTEX(k + (k & 1)), *b = SOFT_VERTEX(k + 1 - (k & 1)), *c = SOFT_VERTEX(k + 2);
+                    if (a && b && c)
+                        sim_soft_triangle(a, b, c, cull);
+                }
+                break;
+            default:
+                for (int k = 0; k + 2 < count; k += 3) {
+                    const sim_soft_vertex_t *a = SOFT_VERTEX(k), *b = SOFT_VERTEX(k + 1), *c = SOFT_VERTEX(k + 2);
+                    if (a && b && c)
+                        sim_soft_triangle(a, b, c, cull);
+                }
+                break;
+        }
+#undef SOFT_VERTEX
+    }
+}
+
+// The software counterpart of the command walk in sim_context_submit,
+// rendering into the target's CPU buffers
+static void sim_soft_submit(sim_context_t *ctx, const sg_pass *pass) {
+    sim_soft_t *soft = &sim.soft;
+    sim_render_target_t *rt = NULL;
+    for (int i = 0; i < sim.target_count; i++)
+        if (sim.targets[i].attachments.id == pass->attachments.id && sim.targets[i].soft_color) {
+            rt = &sim.targets[i];
+            break;
+        }
+    assert(rt);
+    soft->color = rt->soft_color;
+    soft->depth = rt->soft_depth;
+    soft->width = rt->width;
+    soft->height = rt->height;
+    soft->tiles_x = (rt->width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    soft->tiles_y = (rt->height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    int tile_count = soft->tiles_x * soft->tiles_y;
+    if (tile_count > soft->bin_count) {
+        soft->bins = realloc(soft->bins, tile_count * sizeof(sim_soft_bin_t));
+        assert(soft->bins);
+        memset(soft->bins + soft->bin_count, 0, (tile_count - soft->bin_count) * sizeof(sim_soft_bin_t));
+        soft->bin_count = tile_count;
+    }
+    if (!soft->triangles) {
+        soft->triangles = malloc(MAX_SOFT_TRIANGLES * sizeof(sim_soft_triangle_t));
+        assert(soft->triangles);
+    }
+    soft->clear = 1;
+    const sg_color *clear = &pass->action.colors[0].clear_value;
+    soft->clear_color[0] = unorm8(clear->r);
+    soft->clear_color[1] = unorm8(clear->g);
+    soft->clear_color[2] = unorm8(clear->b);
+    soft->clear_color[3] = unorm8(clear->a);
+
+    float viewport[4] = {0.f, 0.f, (float)rt->width, (float)rt->height};
+    int scissor[4] = {0, 0, rt->width, rt->height};
+    for (int i = 0; i < ctx->main.commands.count; i++) {
+        sim_command_t *cursor = &ctx->main.commands.commands[i];
+        switch (cursor->type) {
+            case SIM_CMD_VIEWPORT:;
+                sim_rect_t *rect = &cursor->rect;
+                viewport[0] = rect->x;
+                viewport[1] = rt->height - (rect->y + rect->h);
+                viewport[2] = rect->w;
+                viewport[3] = rect->h;
+                break;
+            case SIM_CMD_SCISSOR_RECT:
+                rect = &cursor->rect;
+                scissor[0] = (int)rect->x;
+                scissor[1] = (int)(rt->height - (rect->y + rect->h));
+                scissor[2] = (int)rect->w;
+                scissor[3] = (int)rect->h;
+                break;
+            case SIM_CMD_DRAW_CALL:;
+                sim_draw_call_t *call = &cursor->draw_call;
+                sim_soft_draw(ctx, call, viewport, scissor);
+                sim_count_draw(call);
+                if (!call->keep_smp)
+                    sim_destroy_sampler(call->bind.fs.samplers[SLOT_sampler_v]);
+                if (!call->keep_pip)
+                    sim_destroy_pipeline(call->pip);
+                break;
+            default:
+                abort();
+        }
+    }
+    sim_soft_flush();
+    soft->draw_count = 0;
+    ctx->main.vertices.size = 0;
+    ctx->main.instances.size = 0;
+    ctx->main.indices.size = 0;
+}
+
+static void sim_gpu_submit(sim_context_t *ctx, const sg_pass *pass) {
+    sim_stream_upload(&ctx->main.vertices);
+    sim_stream_upload(&ctx->main.instances);
+    sim_stream_upload(&ctx->main.indices);
+
+    sg_begin_pass(pass);
+    // Shadow the last applied state so unchanged pipelines, bindings and
+    // uniforms aren't sent to the backend again. Applying a pipeline
+    // invalidates both bindings and uniforms.
+    uint32_t cur_pip = SG_INVALID_ID;
+    sg_bindings cur_bind;
+    int cur_bind_valid = 0;
+    vs_params_t cur_vs_params;
+    int cur_vs_params_valid = 0;
+    for (int i = 0; i < ctx->main.commands.count; i++) {
+        sim_command_t *cursor = &ctx->main.commands.commands[i];
+        switch (cursor->type) {
+            case SIM_CMD_VIEWPORT:;
+                sim_rect_t *rect = &cursor->rect;
+                sg_apply_viewportf(rect->x, rect->y, rect->w, rect->h, true);
+                break;
+            case SIM_CMD_SCISSOR_RECT:
+                rect = &cursor->rect;
+                sg_apply_scissor_rectf(rect->x, rect->y, rect->w, rect->h, true);
+                break;
+            case SIM_CMD_DRAW_CALL:;
+                sim_draw_call_t *call = &cursor->draw_call;
+                if (call->vstream) {
+                    call->bind.vertex_buffers[0] = ctx->main.vertices.buf;
+                    call->bind.vertex_buffer_offsets[0] = ctx->main.vertices.base + call->voffset;
+                }
+                if (call->index_stream) {
+                    call->bind.index_buffer = ctx->main.indices.buf;
+                    call->bind.index_buffer_offset = ctx->main.indices.base + call->index_offset;
+                }
+                call->bind.vertex_buffers[1] = ctx->main.instances.buf;
+                call->bind.vertex_buffer_offsets[1] = ctx->main.instances.base + call->ioffset;
+                if (call->pip.id != cur_pip) {
+                    sg_apply_pipeline(call->pip);
+                    cur_pip = call->pip.id;
+                    cur_bind_valid = 0;
+                    cur_vs_params_valid = 0;
+                }
+                if (!cur_bind_valid || memcmp(&cur_bind, &call->bind, sizeof(sg_bindings))) {
+                    sg_apply_bindings(&call->bind);
+                    cur_bind = call->bind;
+                    cur_bind_valid = 1;
+                }
+                if (!cur_vs_params_valid ||
+                    memcmp(&cur_vs_params.projection, &call->projection, sizeof(hmm_mat4)) ||
+                    memcmp(&cur_vs_params.texture_matrix, &call->texture_matrix, sizeof(hmm_mat4))) {
+                    cur_vs_params.texture_matrix = call->texture_matrix;
+                    cur_vs_params.projection = call->projection;
+                    sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &SG_RANGE(cur_vs_params));
+                    cur_vs_params_valid = 1;
+                }
+                sg_draw(0, call->index_count ? call->index_count : call->vcount, call->icount);
+                sim_count_draw(call);
+                if (!call->keep_smp)
+                    sim_destroy_sampler(call->bind.fs.samplers[SLOT_sampler_v]);
+                if (!call->keep_pip) {
+                    sim_destroy_pipeline(call->pip);
+                    cur_pip = SG_INVALID_ID;
+                }
+                break;
+            default:
+                abort();
+        }
+    }
+    sg_end_pass();
+}
+
+// Submits everything recorded into a context's main recorder as one pass
+static void sim_context_submit(sim_context_t *ctx, const sg_pass *pass) {
+    sim_upload_atlases();
+    if (ctx != &sim.context)
+        // draws recorded straight into the context deferred their state
+        for (int i = 0; i < ctx->main.commands.count; i++) {
+            sim_command_t *command = &ctx->main.commands.commands[i];
+            if (command->type != SIM_CMD_DRAW_CALL || command->draw_call.pip.id)
+                continue;
+            sim_resolve_draw_call(&command->draw_call);
+            if (ctx->draw_order == SIM_DRAW_ORDER_SORTED)
+                command->draw_call.sort_key = sim_sort_key(&ctx->main, &command->draw_call);
+        }
+    if (ctx->draw_order == SIM_DRAW_ORDER_SORTED)
+        sim_sort_commands(ctx);
+    sim_update_vertex_high_water(&ctx->main);
+    if (sim.soft.enabled)
+        sim_soft_submit(ctx, pass);
+    else
+        sim_gpu_submit(ctx, pass);
+    sim.stats.commands += ctx->main.commands.count;
+    ctx->main.commands.count = 0;
+    sim.frame_index++;
+    ctx->pipeline_epoch = sim.frame_index;
+    ctx->frame_index++;
+    if (ctx->retain.count)
+        sim_retain_evict(ctx);
+    if (sim.released_list_count)
+        sim_collect_lists(0);
+}
+
+// Closes the frame's counters, sokol's own ones are for the frame just
+// committed
+static void sim_frame_stats_end(uint64_t submit_start) {
+    sim_frame_stats_t *stats = &sim.stats;
+    stats->submit_ms = stm_ms(stm_since(submit_start));
+    sg_frame_stats sokol = sg_query_frame_stats();
+    stats->sokol.passes = sokol.num_passes;
+    stats->sokol.apply_pipeline = sokol.num_apply_pipeline;
+    stats->sokol.apply_bindings = sokol.num_apply_bindings;
+    stats->sokol.apply_uniforms = sokol.num_apply_uniforms;
+    stats->sokol.draws = sokol.num_draw;
+    stats->sokol.uniform_bytes = sokol.size_apply_uniforms;
+    stats->sokol.buffer_bytes = sokol.size_update_buffer + sokol.size_append_buffer;
+    stats->sokol.image_bytes = sokol.size_update_image;
+    sim.last_stats = *stats;
+    memset(stats, 0, sizeof(sim_frame_stats_t));
+}
+
+static void frame(void) {
+    // headless frames advance a fixed 1/60s so runs are reproducible
+    const float t = sim.headless.enabled ? 1.f : (float)(sapp_frame_duration() * 60.);
+    uint64_t start = stm_now();
+    if (sim.pipeline.enabled) {
+        sim_pipeline_frame(t);
+        start = stm_now();
+    } else {
+        sim.loop(t);
+        sim.stats.loop_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        // a context left current by the loop callback doesn't leak into submission
+        sim_thread_context = NULL;
+        sim_flush_sprites();
+        sim_merge_recorders(&sim.context, &sim.context.main);
+    }
+    sg_pass pass = {
+        .action = {
+            .colors[0] = {
+                .load_action = SG_LOADACTION_CLEAR,
+                .clear_value = sim.context.main.state.clear_color
+            }
+        }
+    };
+    if (sim.headless.enabled)
+        pass.attachments = sim_get_render_target(sim.headless.target)->attachments;
+    else
+        pass.swapchain = sglue_swapchain();
+    sim_context_submit(&sim.context, &pass);
+    sg_commit();
+    sim.commit_count++;
+    sim_frame_stats_end(start);
+    
+    if (!sim.pipeline.enabled) {
+        memcpy(&sim.last_input, &sim.current_input, sizeof(sim_input_t));
+        memset(&sim.current_input, 0, sizeof(sim_input_t));
+    }
+}
+
+static void event(const sapp_event *e) {
+    // the loop thread reads current_input while a pipelined frame records
+    sim_input_t *input = sim.pipeline.enabled ? &sim.pipeline.input : &sim.current_input;
+    switch (e->type) {
+        case SAPP_EVENTTYPE_KEY_UP:
         case SAPP_EVENTTYPE_KEY_DOWN:
-            sim.current_input.keys[e->key_code].down = SAPP_EVENTTYPE_KEY_DOWN;
-            sim.current_input.keys[e->key_code].timestamp = stm_now();
-            sim.current_input.modifier = e->modifiers;
+            input->keys[e->key_code].down = SAPP_EVENTTYPE_KEY_DOWN;
+            input->keys[e->key_code].timestamp = stm_now();
+            input->modifier = e->modifiers;
             break;
         case SAPP_EVENTTYPE_MOUSE_UP:
         case SAPP_EVENTTYPE_MOUSE_DOWN:
-            sim.current_input.buttons[e->mouse_button].down = SAPP_EVENTTYPE_MOUSE_DOWN;
-            sim.current_input.buttons[e->mouse_button].timestamp = stm_now();
-            sim.current_input.modifier = e->modifiers;
+            input->buttons[e->mouse_button].down = SAPP_EVENTTYPE_MOUSE_DOWN;
+            input->buttons[e->mouse_button].timestamp = stm_now();
+            input->modifier = e->modifiers;
             break;
         case SAPP_EVENTTYPE_MOUSE_MOVE:
-            sim.current_input.cursor.x = e->mouse_x;
-            sim.current_input.cursor.y = e->mouse_y;
+            input->cursor.x = e->mouse_x;
+            input->cursor.y = e->mouse_y;
             break;
         case SAPP_EVENTTYPE_MOUSE_SCROLL:
-            sim.current_input.scroll.x = e->scroll_x;
-            sim.current_input.scroll.y = e->scroll_y;
+            input->scroll.x = e->scroll_x;
+            input->scroll.y = e->scroll_y;
             break;
         default:
             break;
     }
 }
 
+static void sim_release_commands(sim_command_queue_t *queue) {
+    for (int i = 0; i < queue->count; i++) {
+        if (queue->commands[i].type != SIM_CMD_DRAW_CALL)
+            continue;
+        sim_draw_call_t *call = &queue->commands[i].draw_call;
+        if (call->pip.id && !call->keep_pip)
+            sim_destroy_pipeline(call->pip);
+        if (call->bind.fs.samplers[SLOT_sampler_v].id && !call->keep_smp)
+            sim_destroy_sampler(call->bind.fs.samplers[SLOT_sampler_v]);
+    }
+    free(queue->commands);
+}
+
+static void sim_release_stream(sim_stream_t *stream) {
+    if (stream->buf.id != SG_INVALID_ID)
+        sim_destroy_buffer(stream->buf);
+    free(stream->data);
+}
+
+static void sim_release_recorder(sim_recorder_t *rec) {
+    sim_release_commands(&rec->commands);
+    sim_release_stream(&rec->vertices);
+    sim_release_stream(&rec->instances);
+    sim_release_stream(&rec->indices);
+    for (int i = 0; i < rec->sprites.bucket_count; i++)
+        free(rec->sprites.buckets[i].vertices);
+    free(rec->sprites.buckets);
+}
+
+static void sim_release_context(sim_context_t *context) {
+    sim_release_recorder(&context->main);
+    for (int i = 0; i < context->recorder_count; i++) {
+        sim_release_recorder(context->recorders[i]);
+        free(context->recorders[i]);
+    }
+    for (int i = 0; i < context->retain.count; i++)
+        sim_retain_release(&context->retain.entries[i]);
+    free(context->retain.entries);
+    free(context->retain.table);
+    free(context->sort.items);
+    free(context->sort.tmp);
+    free(context->sort.commands);
+}
+
+// Frees everything init() and the app created and puts the state back the
+// way init() expects to find it, so sim_run_headless can run again. The
+// callbacks and the sim_set_* settings are kept.
+static void sim_release_state(void) {
+    sim_thread_context = NULL;
+    while (sim.contexts != &sim.context)
+        sim_context_destroy(sim.contexts);
+    sim_release_context(&sim.context);
+    memset(&sim.context, 0, sizeof(sim_context_t));
+    sim.contexts = NULL;
+    for (int i = 0; i < 2; i++)
+        sim_release_recorder(&sim.pipeline.recorders[i]);
+    memset(sim.pipeline.recorders, 0, sizeof(sim.pipeline.recorders));
+    for (int i = 0; i < sim.list_count; i++)
+        if (sim.lists[i].commands)
+            sim_release_list(i + 1);
+    free(sim.lists);
+    sim.lists = NULL;
+    sim.list_count = 0;
+    sim_collect_lists(1);
+    free(sim.released_lists);
+    sim.released_lists = NULL;
+    sim.released_list_capacity = 0;
+    for (int i = 0; i < sim.atlas_count; i++)
+        if (sim.atlases[i].pages)
+            sim_atlas_destroy(i + 1);
+    free(sim.atlases);
+    sim.atlases = NULL;
+    sim.atlas_count = 0;
+    for (int i = 0; i < sim.target_count; i++)
+        if (sim.targets[i].color.id != SG_INVALID_ID)
+            sim_render_target_release(i + 1);
+    free(sim.targets);
+    sim.targets = NULL;
+    sim.target_count = 0;
+    for (int i = 0; i < sim.buffer_count; i++)
+        if (sim.buffers[i].vbuf.id != SG_INVALID_ID)
+            sim_release_buffer(i + 1);
+    free(sim.buffers);
+    sim.buffers = NULL;
+    sim.buffer_count = 0;
+    for (int i = 0; i < sim.pipelines.count; i++)
+        sim_destroy_pipeline(sim.pipelines.entries[i].pip);
+    memset(&sim.pipelines, 0, sizeof(sim_pipeline_cache_t));
+    for (int i = 0; i < sim.samplers.count; i++)
+        sim_destroy_sampler(sim.samplers.samplers[i]);
+    memset(&sim.samplers, 0, sizeof(sim_sampler_cache_t));
+    sim_soft_forget(&sim.soft.buffers, sim.quad_indices.id);
+    sim_destroy_buffer(sim.quad_indices);
+    sim.quad_indices.id = SG_INVALID_ID;
+    memset(sim.formats, 0, sizeof(sim.formats));
+    memset(&sim.current_input, 0, sizeof(sim_input_t));
+    memset(&sim.last_input, 0, sizeof(sim_input_t));
+    memset(&sim.stats, 0, sizeof(sim_frame_stats_t));
+    memset(&sim.last_stats, 0, sizeof(sim_frame_stats_t));
+}
+
 static void cleanup(void) {
+    sim_pipeline_shutdown();
     if (sim.deinit)
         sim.deinit();
+    sim_release_state();
+    sim_soft_shutdown();
     sg_shutdown();
 }
 
@@ -388,6 +3317,24 @@ void sim_set_window_size(int width, int height) {
     }
 }
 
+void sim_set_pipelined(int enabled) {
+#if defined(SIM_THREADS)
+    if (!sim.running)
+        sim.pipeline.enabled = enabled;
+#else
+    (void)enabled;
+#endif
+}
+
+void sim_set_software_renderer(int threads) {
+    if (sim.running || sim.headless.enabled)
+        return;
+    if (threads < 0)
+        threads = sim_cpu_count();
+    sim.soft.enabled = threads > 0;
+    sim.soft.thread_count = threads < MAX_SOFT_THREADS ? threads : MAX_SOFT_THREADS;
+}
+
 void sim_set_window_title(const char *title) {
     if (sim.running)
         sapp_set_window_title(title);
@@ -410,6 +3357,8 @@ void sim_set_exit_callback(void(*callback)(void)) {
 int sim_run(void) {
     assert(!sim.running);
     assert(sim.loop);
+    // the software renderer has no way to present to a window
+    sim.soft.enabled = 0;
     sim.app_desc.init_cb = init;
     sim.app_desc.frame_cb = frame;
     sim.app_desc.event_cb = event;
@@ -418,11 +3367,132 @@ int sim_run(void) {
     return 0;
 }
 
+#if defined(SIM_EGL)
+// A surfaceless context, headless frames only ever render offscreen
+static int sim_egl_create(void) {
+    EGLDisplay display = EGL_NO_DISPLAY;
+#if defined(EGL_PLATFORM_SURFACELESS_MESA)
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+        return 0;
+    EGLConfig config;
+    EGLint count = 0;
+    EGLContext context = EGL_NO_CONTEXT;
+    static const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    static const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, config_attribs, &config, 1, &count) || !count)
+        goto BAIL;
+    if ((context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs)) == EGL_NO_CONTEXT)
+        goto BAIL;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        goto BAIL;
+    sim.headless.display = display;
+    sim.headless.context = context;
+    return 1;
+BAIL:
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+    return 0;
+}
+
+static void sim_egl_destroy(void) {
+    eglMakeCurrent(sim.headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(sim.headless.display, sim.headless.context);
+    eglTerminate(sim.headless.display);
+}
+#endif
+
+// Copies the headless target into sim.headless.pixels, top row first. The
+// software renderer and GL can read it back, other backends leave pixels NULL.
+static void sim_headless_read_pixels(void) {
+    sim_render_target_t *rt = sim_get_render_target(sim.headless.target);
+    int pitch = rt->width * 4;
+    sim.headless.pixels = realloc(sim.headless.pixels, pitch * rt->height);
+    assert(sim.headless.pixels);
+    if (sim.soft.enabled)
+        memcpy(sim.headless.pixels, rt->soft_color, pitch * rt->height);
+    else {
+#if defined(SIM_GL) && !defined(SOKOL_DUMMY_BACKEND)
+        sg_gl_attachments_info info = sg_gl_query_attachments_info(rt->attachments);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, rt->resolve.id != SG_INVALID_ID ? info.msaa_resolve_framebuffer[0] : info.framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, rt->width, rt->height, GL_RGBA, GL_UNSIGNED_BYTE, sim.headless.pixels);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        sg_reset_state_cache();
+#else
+        free(sim.headless.pixels);
+        sim.headless.pixels = NULL;
+        return;
+#endif
+    }
+    // both have their origin at the bottom left
+    unsigned char *row = malloc(pitch);
+    assert(row);
+    for (int y = 0; y < rt->height / 2; y++) {
+        unsigned char *a = sim.headless.pixels + y * pitch;
+        unsigned char *b = sim.headless.pixels + (rt->height - 1 - y) * pitch;
+        memcpy(row, a, pitch);
+        memcpy(a, b, pitch);
+        memcpy(b, row, pitch);
+    }
+    free(row);
+}
+
+int sim_run_headless(int width, int height, int frames) {
+    assert(!sim.running && !sim.headless.enabled);
+    assert(sim.loop);
+    assert(width > 0 && height > 0 && frames > 0);
+#if defined(SIM_EGL)
+    if (!sim_egl_create())
+        return -1;
+#elif !defined(SOKOL_DUMMY_BACKEND)
+    // the other backends can't get a device without a window
+    return -1;
+#endif
+    sim.headless.enabled = 1;
+    sim.headless.width = width;
+    sim.headless.height = height;
+    init();
+    for (int i = 0; i < frames; i++)
+        frame();
+    sim_headless_read_pixels();
+    sim_render_target_release(sim.headless.target);
+    cleanup();
+#if defined(SIM_EGL)
+    sim_egl_destroy();
+#endif
+    sim.headless.enabled = 0;
+    return 0;
+}
+
+const unsigned char* sim_headless_pixels(void) {
+    return sim.headless.pixels;
+}
+
 int sim_window_width(void) {
+    if (sim.headless.enabled)
+        return sim.headless.width;
     return sim.running ? sapp_width() : -1;
 }
 
 int sim_window_height(void) {
+    if (sim.headless.enabled)
+        return sim.headless.height;
     return sim.running ? sapp_height() : -1;
 }
 
@@ -586,7 +3656,7 @@ void sim_matrix_mode(int mode) {
         case SIM_MATRIXMODE_PROJECTION:
         case SIM_MATRIXMODE_TEXTURE:
         case SIM_MATRIXMODE_MODELVIEW:
-            sim.state.matrix_mode = mode;
+            sim_recorder()->state.matrix_mode = mode;
             break;
         default:
             abort(); // unknown mode
@@ -594,14 +3664,16 @@ void sim_matrix_mode(int mode) {
 }
 
 void sim_push_matrix(void) {
-    sim_matrix_stack_t *cs = &sim.state.matrix_stack[sim.state.matrix_mode];
+    sim_recorder_t *rec = sim_recorder();
+    sim_matrix_stack_t *cs = &rec->state.matrix_stack[rec->state.matrix_mode];
     assert(cs->count + 1 < MAX_MATRIX_STACK);
     cs->stack[cs->count] = cs->stack[cs->count-1];
     cs->count++;
 }
 
 void sim_pop_matrix(void) {
-    sim_matrix_stack_t *cs = &sim.state.matrix_stack[sim.state.matrix_mode];
+    sim_recorder_t *rec = sim_recorder();
+    sim_matrix_stack_t *cs = &rec->state.matrix_stack[rec->state.matrix_mode];
     if (cs->count == 1)
         memset(&cs->stack, 0, MAX_MATRIX_STACK * sizeof(hmm_mat4));
     else
@@ -656,32 +3728,91 @@ void sim_look_at(float eyeX, float eyeY, float eyeZ,
 }
 
 void sim_clear_color(float r, float g, float b, float a) {
-    sim.state.clear_color = (sg_color){r, g, b, a};
+    sim_recorder()->state.clear_color = (sg_color){r, g, b, a};
 }
 
 void sim_viewport(int x, int y, int width, int height) {
-    sim_rect_t *rect = malloc(sizeof(sim_rect_t));
+    sim_flush_sprites();
+    sim_rect_t *rect = &sim_push_command(SIM_CMD_VIEWPORT)->rect;
     rect->x = x;
     rect->y = y;
     rect->w = width;
     rect->h = height;
-    sim_push_command(SIM_CMD_VIEWPORT, rect);
 }
 
 void sim_scissor_rect(int x, int y, int width, int height) {
-    sim_rect_t *rect = malloc(sizeof(sim_rect_t));
+    sim_flush_sprites();
+    sim_rect_t *rect = &sim_push_command(SIM_CMD_SCISSOR_RECT)->rect;
     rect->x = x;
     rect->y = y;
     rect->w = width;
     rect->h = height;
-    sim_push_command(SIM_CMD_SCISSOR_RECT, rect);
+}
+
+// Corners are rotated about the sprite's centre and then transformed by the
+// 2D part of the modelview, both folded into one affine transform so each
+// sprite costs a single multiply-add per axis over its four corners.
+void sim_sprite(int texture, float x, float y, float w, float h, float u0, float v0, float u1, float v1, unsigned int color, float rotation) {
+    sim_recorder_t *rec = sim_recorder();
+    assert(!rec->state.in_batch);
+    sim_sprite_batch_t *sprites = &rec->sprites;
+    sim_sprite_state_t state;
+    sim_sprite_snapshot(&state);
+    if (memcmp(&state, &sprites->state, sizeof(sim_sprite_state_t))) {
+        sim_flush_sprites();
+        sprites->state = state;
+    }
+
+    hmm_mat4 *m = sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW);
+    float c = cosf(rotation), s = sinf(rotation);
+    float hw = w * .5f, hh = h * .5f;
+    float cx = x + hw, cy = y + hh;
+    float m00 = m->Elements[0][0], m10 = m->Elements[1][0], m30 = m->Elements[3][0];
+    float m01 = m->Elements[0][1], m11 = m->Elements[1][1], m31 = m->Elements[3][1];
+    float ax = m00 * c + m10 * s, bx = m10 * c - m00 * s, tx = m00 * cx + m10 * cy + m30;
+    float ay = m01 * c + m11 * s, by = m11 * c - m01 * s, ty = m01 * cx + m11 * cy + m31;
+
+    sim_sprite_bucket_t *bucket = sim_sprite_bucket((sg_image){.id=(uint32_t)texture});
+    sim_vertex_pos2_uv_rgba8_t *v = sim_sprite_reserve(bucket);
+    // top-left, top-right, bottom-right, bottom-left
+#if defined(SIM_SSE)
+    __m128 dx = _mm_setr_ps(-hw, hw, hw, -hw);
+    __m128 dy = _mm_setr_ps(-hh, -hh, hh, hh);
+    __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ax), dx), _mm_mul_ps(_mm_set1_ps(bx), dy)), _mm_set1_ps(tx));
+    __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ay), dx), _mm_mul_ps(_mm_set1_ps(by), dy)), _mm_set1_ps(ty));
+    __m128 lo = _mm_unpacklo_ps(px, py);
+    __m128 hi = _mm_unpackhi_ps(px, py);
+    _mm_storel_pi((__m64*)&v[0].x, lo);
+    _mm_storeh_pi((__m64*)&v[1].x, lo);
+    _mm_storel_pi((__m64*)&v[2].x, hi);
+    _mm_storeh_pi((__m64*)&v[3].x, hi);
+#else
+    static const float dx[4] = {-1.f, 1.f, 1.f, -1.f};
+    static const float dy[4] = {-1.f, -1.f, 1.f, 1.f};
+    for (int i = 0; i < 4; i++) {
+        v[i].x = ax * dx[i] * hw + bx * dy[i] * hh + tx;
+        v[i].y = ay * dx[i] * hw + by * dy[i] * hh + ty;
+    }
+#endif
+    v[0].u = u0; v[0].v = v0;
+    v[1].u = u1; v[1].v = v0;
+    v[2].u = u1; v[2].v = v1;
+    v[3].u = u0; v[3].v = v1;
+    uint8_t rgba[4] = {(color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF};
+    for (int i = 0; i < 4; i++)
+        memcpy(v[i].color, rgba, 4);
+    sprites->pending = 1;
 }
 
 void sim_blend_mode(int mode) {
-    if (mode == sim.state.blend_mode)
+    sim_recorder_t *rec = sim_recorder();
+    if (mode == rec->state.blend_mode)
         return;
-    sg_blend_state *blend = &sim.state.blend;
+    sg_blend_state *blend = &rec->state.blend;
     switch (mode) {
+        default:
+        case SIM_BLEND_DEFAULT:
+            mode = SIM_BLEND_NONE;
         case SIM_BLEND_NONE:
             blend->enabled = false;
             blend->src_factor_rgb = SG_BLENDFACTOR_ONE;
@@ -718,7 +3849,6 @@ void sim_blend_mode(int mode) {
             blend->dst_factor_alpha = SG_BLENDFACTOR_ONE;
             blend->op_alpha = SG_BLENDOP_ADD;
             break;
-        default:
         case SIM_BLEND_MUL:
             blend->enabled = true;
             blend->src_factor_rgb = SG_BLENDFACTOR_DST_COLOR;
@@ -729,11 +3859,12 @@ void sim_blend_mode(int mode) {
             blend->op_alpha = SG_BLENDOP_ADD;
             break;
     }
-    sim.state.blend_mode = mode;
+    rec->state.blend_mode = mode;
 }
 
 void sim_depth_func(int func) {
-    if (func == sim.state.pip_desc.depth.compare)
+    sim_recorder_t *rec = sim_recorder();
+    if (func == rec->state.pip_desc.depth.compare)
         return;
     switch (func) {
         default:
@@ -748,13 +3879,53 @@ void sim_depth_func(int func) {
         case SIM_CMP_GREATER_EQUAL:
         case SIM_CMP_ALWAYS:
         case SIM_CMP_NUM:
-            sim.state.pip_desc.depth.compare = (sg_compare_func)func;
+            rec->state.pip_desc.depth.compare = (sg_compare_func)func;
+            break;
+    }
+}
+
+void sim_vertex_format(int format) {
+    switch (format) {
+        default:
+            format = SIM_VERTEX_FORMAT_DEFAULT;
+        case SIM_VERTEX_FORMAT_DEFAULT:
+        case SIM_VERTEX_FORMAT_FULL:
+        case SIM_VERTEX_FORMAT_POS2_UV_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_UV_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8:
+        case SIM_VERTEX_FORMAT_POS2_UV_COLOR:
+        case SIM_VERTEX_FORMAT_POS3_UV_COLOR:
+        case SIM_VERTEX_FORMAT_POS3_COLOR:
+            sim_recorder()->state.vertex_format = format;
             break;
     }
 }
 
+void sim_draw_order(int order) {
+    switch (order) {
+        default:
+        case SIM_DRAW_ORDER_DEFAULT:
+            order = SIM_DRAW_ORDER_SUBMISSION;
+        case SIM_DRAW_ORDER_SUBMISSION:
+        case SIM_DRAW_ORDER_SORTED:
+            sim_context()->draw_order = order;
+            break;
+    }
+}
+
+void sim_auto_retain(int frames) {
+    sim_context()->retain.frames = frames < 0 ? DEFAULT_RETAIN_FRAMES : frames;
+}
+
+void sim_draw_layer(int layer) {
+    assert(layer >= 0 && layer < 256);
+    sim_recorder()->state.layer = layer;
+}
+
 void sim_cull_mode(int mode) {
-    if (mode == sim.state.pip_desc.cull_mode)
+    sim_recorder_t *rec = sim_recorder();
+    if (mode == rec->state.pip_desc.cull_mode)
         return;
     switch (mode) {
         default:
@@ -763,20 +3934,29 @@ void sim_cull_mode(int mode) {
         case SIM_CULL_NONE:
         case SIM_CULL_FRONT:
         case SIM_CULL_BACK:
-            sim.state.pip_desc.cull_mode = mode;
+            rec->state.pip_desc.cull_mode = mode;
             break;
     }
 }
 
 void sim_begin(int mode) {
-    assert(!sim.state.draw_call.vertices && !sim.state.draw_call.instances);
-    if (sim.state.draw_call.vertices)
+    sim_recorder_t *rec = sim_recorder();
+    assert(!rec->state.in_batch);
+    if (rec->state.in_batch)
         sim_end();
-    sim.state.draw_call.vertices = malloc(0);
-    sim.state.draw_call.vcount = 0;
-    sim.state.draw_call.instances = malloc(0);
-    sim.state.draw_call.icount = 0;
+    sim_flush_sprites();
+    rec->state.in_batch = 1;
+    rec->state.draw_call.vcount = 0;
+    rec->state.draw_call.voffset = rec->vertices.size;
+    rec->state.draw_call.icount = 0;
+    rec->state.draw_call.ioffset = rec->instances.size;
+    rec->state.draw_call.index_count = 0;
+    rec->state.draw_call.index_offset = rec->indices.size;
+    rec->state.batch_attrs = 0;
+    rec->state.batch_format = SIM_VERTEX_FORMAT_DEFAULT;
+    rec->state.quads = mode == SIM_DRAW_QUADS;
     switch (mode) {
+        case SIM_DRAW_QUADS:
         default:
             mode = SIM_DRAW_TRIANGLES;
         case SIM_DRAW_TRIANGLES:
@@ -784,7 +3964,7 @@ void sim_begin(int mode) {
         case SIM_DRAW_LINES:
         case SIM_DRAW_LINE_STRIP:
         case SIM_DRAW_TRIANGLE_STRIP:
-            sim.state.pip_desc.primitive_type = mode;
+            rec->state.pip_desc.primitive_type = mode;
             break;
     }
 }
@@ -798,31 +3978,124 @@ void sim_vertex2f(float x, float y) {
 }
 
 void sim_vertex3f(float x, float y, float z) {
-    sim.state.current_vertex.position = HMM_Vec4(x, y, z, 1.f);
+    sim_recorder_t *rec = sim_recorder();
+    rec->state.current_vertex.position = HMM_Vec4(x, y, z, 1.f);
+    if (z != 0.f)
+        rec->state.batch_attrs |= SIM_ATTR_Z;
     sim_push_vertex();
 }
 
+static void set_attr(int attr, int enabled) {
+    sim_recorder_t *rec = sim_recorder();
+    if (enabled)
+        rec->state.current_attrs |= attr;
+    else
+        rec->state.current_attrs &= ~attr;
+}
+
 void sim_texcoord2f(float x, float y) {
-    sim.state.current_vertex.texcoord = HMM_Vec2(x, y);
+    sim_recorder()->state.current_vertex.texcoord = HMM_Vec2(x, y);
+    set_attr(SIM_ATTR_TEXCOORD, x != 0.f || y != 0.f);
 }
 
 void sim_normal3f(float x, float y, float z) {
-    sim.state.current_vertex.normal = HMM_Vec3(x, y, z);
+    sim_recorder()->state.current_vertex.normal = HMM_Vec3(x, y, z);
+    set_attr(SIM_ATTR_NORMAL, x != 0.f || y != 0.f || z != 0.f);
 }
 
 void sim_color4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
-    sim.state.current_vertex.color = HMM_Vec4((float)r / 255.f,
+    sim_recorder()->state.current_vertex.color = HMM_Vec4((float)r / 255.f,
                                               (float)g / 255.f,
                                               (float)b / 255.f,
                                               (float)a / 255.f);
 }
 
 void sim_color3f(float x, float y, float z) {
-    sim.state.current_vertex.color = HMM_Vec4(x, y, z, 1.f);
+    sim_recorder()->state.current_vertex.color = HMM_Vec4(x, y, z, 1.f);
 }
 
 void sim_color4f(float x, float y, float z, float w) {
-    sim.state.current_vertex.color = HMM_Vec4(x, y, z, w);
+    sim_recorder()->state.current_vertex.color = HMM_Vec4(x, y, z, w);
+}
+
+// Vertices can only be appended after a whole number of primitives,
+// otherwise every appended vertex would shift into the wrong one. Strips
+// join their primitives so they never are.
+static int can_append_vertices(int primitive_type, int vcount) {
+    switch (primitive_type) {
+        case SG_PRIMITIVETYPE_POINTS:
+            return 1;
+        case SG_PRIMITIVETYPE_LINES:
+            return vcount % 2 == 0;
+        case SG_PRIMITIVETYPE_TRIANGLES:
+            return vcount % 3 == 0;
+        default:
+            return 0;
+    }
+}
+
+// Folds a finished batch into the previous draw call when both share the
+// same pipeline, bindings and uniforms. Batches drawn with the same
+// modelview are concatenated into one vertex range, batches that repeat the
+// same geometry under different modelviews become extra instances. Either
+// way the merged data must already be contiguous in the frame streams.
+static int sim_merge_draw_call(sim_draw_call_t *call) {
+    sim_recorder_t *rec = sim_recorder();
+    sim_context_t *ctx = sim_context();
+    if (!rec->commands.count)
+        return 0;
+    // never fold a display list's first batch into what came before it
+    if (rec == &ctx->main && ctx->list_recorder.active && rec->commands.count <= ctx->list_recorder.command_start)
+        return 0;
+    sim_command_t *tail = &rec->commands.commands[rec->commands.count-1];
+    if (tail->type != SIM_CMD_DRAW_CALL)
+        return 0;
+    sim_draw_call_t *prev = &tail->draw_call;
+    int quads = call->vstream && call->bind.index_buffer.id == sim.quad_indices.id;
+    // pipelines and samplers of draws recorded off the main thread are
+    // resolved later, until then their state is compared directly
+    if (prev->pip.id != call->pip.id ||
+        prev->format != call->format ||
+        (!call->pip.id && memcmp(&prev->state, &call->state, sizeof(sim_draw_state_t))) ||
+        // the layer isn't part of the pipeline
+        prev->state.layer != call->state.layer ||
+        prev->vstream != call->vstream ||
+        prev->bind.vertex_buffers[0].id != call->bind.vertex_buffers[0].id ||
+        prev->bind.index_buffer.id != call->bind.index_buffer.id ||
+        (!quads && prev->index_count != call->index_count) ||
+        call->index_stream ||
+        prev->bind.fs.images[SLOT_texture_v].id != call->bind.fs.images[SLOT_texture_v].id ||
+        prev->bind.fs.samplers[SLOT_sampler_v].id != call->bind.fs.samplers[SLOT_sampler_v].id ||
+        memcmp(&prev->projection, &call->projection, sizeof(hmm_mat4)) ||
+        memcmp(&prev->texture_matrix, &call->texture_matrix, sizeof(hmm_mat4)))
+        return 0;
+
+    int stride = sim.formats[call->format].stride;
+    int same_geometry = prev->vcount == call->vcount &&
+                        (!call->vstream || !memcmp(rec->vertices.data + prev->voffset,
+                                                   rec->vertices.data + call->voffset,
+                                                   call->vcount * stride));
+    if (same_geometry && prev->index_count == call->index_count &&
+        prev->ioffset + prev->icount * (int)sizeof(sim_vs_inst_t) == call->ioffset) {
+        prev->icount += call->icount;
+        if (call->vstream)
+            rec->vertices.size = call->voffset;
+        return 1;
+    }
+
+    if (!call->vstream ||
+        // quads are already trimmed to whole quads by sim_end()
+        (!quads && !can_append_vertices(call->state.primitive_type, prev->vcount)) ||
+        prev->icount != 1 || call->icount != 1 ||
+        prev->voffset + prev->vcount * stride != call->voffset ||
+        (quads && prev->vcount + call->vcount > MAX_QUAD_COUNT * 4) ||
+        memcmp(rec->instances.data + prev->ioffset, rec->instances.data + call->ioffset, sizeof(sim_vs_inst_t)))
+        return 0;
+    prev->vcount += call->vcount;
+    if (quads)
+        prev->index_count += call->index_count;
+    rec->instances.size = call->ioffset;
+    return 1;
 }
 
 static void make_vs_inst(sim_vs_inst_t *inst, hmm_mat4 model) {
@@ -844,75 +4117,586 @@ static void make_vs_inst(sim_vs_inst_t *inst, hmm_mat4 model) {
                        model.Elements[3][3]);
 }
 
+static hmm_mat4 inst_matrix(const sim_vs_inst_t *inst) {
+    hmm_mat4 result;
+    const hmm_vec4 *rows[4] = {&inst->x, &inst->y, &inst->z, &inst->w};
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 4; col++)
+            result.Elements[col][row] = rows[row]->Elements[col];
+    return result;
+}
+
+void sim_index(int index) {
+    sim_recorder_t *rec = sim_recorder();
+    assert(index >= 0);
+    uint32_t *dst = (uint32_t*)sim_stream_reserve(&rec->indices, sizeof(uint32_t));
+    *dst = (uint32_t)index;
+    rec->indices.size += sizeof(uint32_t);
+    rec->state.draw_call.index_count++;
+}
+
+void sim_index_array(const int *indices, int count) {
+    sim_recorder_t *rec = sim_recorder();
+    assert(indices && count >= 0);
+    uint32_t *dst = (uint32_t*)sim_stream_reserve(&rec->indices, count * sizeof(uint32_t));
+    for (int i = 0; i < count; i++) {
+        assert(indices[i] >= 0);
+        dst[i] = (uint32_t)indices[i];
+    }
+    rec->indices.size += count * sizeof(uint32_t);
+    rec->state.draw_call.index_count += count;
+}
+
+static int vertex_array_format(int layout) {
+    switch (layout) {
+        case SIM_VERTEX_FORMAT_POS2_UV_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_UV_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_RGBA8:
+        case SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8:
+        case SIM_VERTEX_FORMAT_POS2_UV_COLOR:
+        case SIM_VERTEX_FORMAT_POS3_UV_COLOR:
+        case SIM_VERTEX_FORMAT_POS3_COLOR:
+            return layout;
+        default:
+            return SIM_VERTEX_FORMAT_FULL;
+    }
+}
+
+static void copy_strided(void *dst, const void *src, int count, int size, int stride) {
+    if (stride == size)
+        memcpy(dst, src, count * size);
+    else
+        for (int i = 0; i < count; i++)
+            memcpy((unsigned char*)dst + i * size, (const unsigned char*)src + i * stride, size);
+}
+
+void sim_vertex_array(const void *data, int count, int stride, int layout) {
+    sim_recorder_t *rec = sim_recorder();
+    assert(rec->state.in_batch && data && count >= 0);
+    int format = vertex_array_format(layout);
+    int size = sim.formats[format].stride;
+    if (!stride)
+        stride = size;
+    assert(stride >= size);
+    if (!rec->state.draw_call.vcount && !rec->state.batch_format)
+        rec->state.batch_format = format;
+
+    if (rec->state.batch_format == format) {
+        // caller's layout matches the upload layout, copy it in one go
+        copy_strided(sim_stream_reserve(&rec->vertices, count * size), data, count, size, stride);
+        rec->vertices.size += count * size;
+        rec->state.draw_call.vcount += count;
+        return;
+    }
+
+    int dst_format = rec->state.batch_format;
+    int dst_size = dst_format ? sim.formats[dst_format].stride : (int)sizeof(sim_vertex_t);
+    unsigned char *dst = sim_stream_reserve(&rec->vertices, count * dst_size);
+    for (int i = 0; i < count; i++) {
+        sim_vertex_t v;
+        sim_unpack_vertex(format, (const unsigned char*)data + i * stride, &v);
+        if (dst_format)
+            sim_pack_vertices(dst_format, dst + i * dst_size, &v, 1);
+        else
+            memcpy(dst + i * dst_size, &v, sizeof(sim_vertex_t));
+    }
+    rec->vertices.size += count * dst_size;
+    rec->state.draw_call.vcount += count;
+    // mixed with sim_vertex3f() vertices, so auto format selection can't drop anything
+    rec->state.batch_attrs |= SIM_ATTR_Z | SIM_ATTR_NORMAL | SIM_ATTR_TEXCOORD;
+}
+
 void sim_draw(void) {
-    sim.state.draw_call.instances = realloc(sim.state.draw_call.instances, ++sim.state.draw_call.icount * sizeof(sim_vs_inst_t));
-    sim_vs_inst_t *inst = &sim.state.draw_call.instances[sim.state.draw_call.icount-1];
+    sim_recorder_t *rec = sim_recorder();
+    sim_vs_inst_t *inst = (sim_vs_inst_t*)sim_stream_reserve(&rec->instances, sizeof(sim_vs_inst_t));
+    rec->instances.size += sizeof(sim_vs_inst_t);
+    rec->state.draw_call.icount++;
     hmm_mat4 *m = sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW);
     make_vs_inst(inst, m ? *m : HMM_Mat4());
 }
 
+// Narrows the batch's 32 bit indices to 16 bits in place when every
+// vertex is addressable, keeping the index stream 4 byte aligned.
+static sg_index_type sim_pack_indices(sim_draw_call_t *call) {
+    sim_recorder_t *rec = sim_recorder();
+    uint32_t *src = (uint32_t*)(rec->indices.data + call->index_offset);
+    if (call->vcount > 65536)
+        return SG_INDEXTYPE_UINT32;
+    uint16_t *dst = (uint16_t*)src;
+    for (int i = 0; i < call->index_count; i++)
+        dst[i] = (uint16_t)src[i];
+    rec->indices.size = call->index_offset + ((call->index_count * (int)sizeof(uint16_t) + 3) & ~3);
+    return SG_INDEXTYPE_UINT16;
+}
+
+static sim_buffer_t* sim_get_buffer(int buffer) {
+    assert(buffer > 0 && buffer <= sim.buffer_count);
+    sim_buffer_t *result = &sim.buffers[buffer-1];
+    // released slots are zeroed, so this holds on any thread unlike
+    // querying sokol
+    assert(result->vbuf.id != SG_INVALID_ID);
+    return result;
+}
+
+// Makes room for another retained batch by releasing the context's least
+// recently used one. Buffers drawn this frame are still referenced by
+// unsubmitted commands, so if only those are left it fails.
+static int sim_retain_reclaim(sim_context_t *ctx) {
+    if (sim.retained_count < MAX_RETAINED_BATCHES)
+        return 1;
+    sim_retain_entry_t *lru = NULL;
+    for (int i = 0; i < ctx->retain.count; i++) {
+        sim_retain_entry_t *entry = &ctx->retain.entries[i];
+        if (entry->vbuf.id != SG_INVALID_ID && (!lru || entry->last_used < lru->last_used))
+            lru = entry;
+    }
+    if (!lru || lru->last_used >= ctx->frame_index)
+        return 0;
+    sim_retain_release(lru);
+    return 1;
+}
+
+// Swaps a streamed batch for an immutable copy of itself when the same
+// bytes have been recorded before. The first sighting only remembers the
+// hash so geometry that changes every frame never creates buffers, later
+// ones compare the bytes against a copy before reusing the buffers.
+static int sim_retain_draw_call(sim_draw_call_t *call, int format, sg_buffer *vbuf, sg_buffer *ibuf) {
+    sim_recorder_t *rec = sim_recorder();
+    sim_context_t *ctx = sim_context();
+    sim_retain_cache_t *cache = &ctx->retain;
+    const unsigned char *vertices = rec->vertices.data + call->voffset;
+    const unsigned char *indices = rec->indices.data + call->index_offset;
+    int vsize = call->vcount * sim.formats[format].stride;
+    int isize = call->index_stream ? rec->indices.size - call->index_offset : 0;
+    uint64_t hash = sim_hash_xxh64(vertices, vsize, (uint64_t)format);
+    if (isize)
+        hash = sim_hash_xxh64(indices, isize, hash);
+
+    if (cache->count * 2 >= cache->table_size)
+        sim_retain_rebuild();
+    int slot = (int)(hash & (cache->table_size - 1));
+    sim_retain_entry_t *entry = NULL;
+    for (; cache->table[slot] != -1; slot = (slot + 1) & (cache->table_size - 1)) {
+        sim_retain_entry_t *e = &cache->entries[cache->table[slot]];
+        if (e->hash == hash && e->vsize == vsize && e->isize == isize && e->format == format) {
+            entry = e;
+            break;
+        }
+    }
+    if (!entry) {
+        if (cache->count == cache->capacity) {
+            cache->capacity = cache->capacity ? cache->capacity * 2 : 64;
+            cache->entries = realloc(cache->entries, cache->capacity * sizeof(sim_retain_entry_t));
+            assert(cache->entries);
+        }
+        entry = &cache->entries[cache->count];
+        memset(entry, 0, sizeof(sim_retain_entry_t));
+        entry->hash = hash;
+        entry->vsize = vsize;
+        entry->isize = isize;
+        entry->format = format;
+        entry->last_used = ctx->frame_index;
+        cache->table[slot] = cache->count++;
+        return 0;
+    }
+
+    entry->last_used = ctx->frame_index;
+    if (entry->vbuf.id != SG_INVALID_ID) {
+        // a hash collision is streamed as usual
+        if (memcmp(entry->data, vertices, vsize) || (isize && memcmp((unsigned char*)entry->data + vsize, indices, isize)))
+            return 0;
+    } else {
+        if (!sim_retain_reclaim(ctx))
+            return 0;
+        entry->data = malloc(vsize + isize);
+        assert(entry->data);
+        memcpy(entry->data, vertices, vsize);
+        if (isize)
+            memcpy((unsigned char*)entry->data + vsize, indices, isize);
+        sim.retained_count++;
+        entry->vbuf = sim_make_buffer(&(sg_buffer_desc) {
+            .data = (sg_range) {
+                .ptr = vertices,
+                .size = vsize
+            }
+        });
+        if (isize)
+            entry->ibuf = sim_make_buffer(&(sg_buffer_desc) {
+                .type = SG_BUFFERTYPE_INDEXBUFFER,
+                .data = (sg_range) {
+                    .ptr = indices,
+                    .size = isize
+                }
+            });
+        sim_soft_shadow(&sim.soft.buffers, entry->vbuf.id, vertices, vsize, 0, 0, 1);
+        sim_soft_shadow(&sim.soft.buffers, entry->ibuf.id, indices, isize, 0, 0, 1);
+    }
+    *vbuf = entry->vbuf;
+    if (isize)
+        *ibuf = entry->ibuf;
+    rec->vertices.size = call->voffset;
+    if (call->index_stream)
+        rec->indices.size = call->index_offset;
+    call->vstream = 0;
+    call->index_stream = 0;
+    return 1;
+}
+
+static void sim_submit_draw_call(sim_draw_call_t *call, int merge) {
+    if (merge && sim_merge_draw_call(call))
+        return;
+    if (sim_context()->draw_order == SIM_DRAW_ORDER_SORTED && call->pip.id)
+        call->sort_key = sim_sort_key(sim_recorder(), call);
+    memcpy(&sim_push_command(SIM_CMD_DRAW_CALL)->draw_call, call, sizeof(sim_draw_call_t));
+}
+
 void sim_end(void) {
-    if (!sim.state.draw_call.instances || !sim.state.draw_call.icount)
+    sim_recorder_t *rec = sim_recorder();
+    if (!rec->state.in_batch || !rec->state.draw_call.icount)
         goto BAIL;
-   
-    static sg_buffer_desc b1 = {
-        .size = sizeof(sim_vs_inst_t),
-        .usage = SG_USAGE_STREAM
-    };
+
+    sim_draw_call_t *call = &rec->state.draw_call;
     sg_buffer vbuf = {.id=SG_INVALID_ID};
-    
-    sim_draw_call_t *draw_call = malloc(sizeof(sim_draw_call_t));
-    sim.state.draw_call.pip = sg_make_pipeline(&sim.state.pip_desc);
-    sim.state.draw_call.projection = *sim_matrix_stack_head(SIM_MATRIXMODE_PROJECTION);
-    sim.state.draw_call.texture_matrix = *sim_matrix_stack_head(SIM_MATRIXMODE_TEXTURE);
-    
-    if (sim.state.current_buffer.id != SG_INVALID_ID) {
-        vbuf = sim.state.current_buffer;
-        sim.state.draw_call.keep_vbuf = 1;
-        sim.state.current_buffer.id = SG_INVALID_ID;
-        goto SKIP;
-    }
-    
-    sg_buffer_desc b0 = {
-        .data = (sg_range) {
-            .ptr = sim.state.draw_call.vertices,
-            .size = sim.state.draw_call.vcount * sizeof(sim_vertex_t)
+    sg_buffer ibuf = {.id=SG_INVALID_ID};
+    sg_index_type index_type = SG_INDEXTYPE_NONE;
+    int format = rec->state.vertex_format;
+    call->vstream = 0;
+    call->index_stream = 0;
+    if (rec->state.current_buffer) {
+        sim_buffer_t *stored = sim_get_buffer(rec->state.current_buffer);
+        // vertices and indices pushed alongside a stored buffer are never drawn
+        rec->vertices.size = call->voffset;
+        rec->indices.size = call->index_offset;
+        vbuf = stored->vbuf;
+        ibuf = stored->ibuf;
+        call->vcount = stored->vcount;
+        call->index_count = stored->index_count;
+        index_type = stored->index_type;
+        format = stored->format;
+        rec->state.current_buffer = 0;
+    } else {
+        // a trailing partial quad is dropped
+        if (rec->state.quads && !call->index_count && !(call->vcount -= call->vcount % 4))
+            goto BAIL;
+        if (rec->state.batch_format)
+            // already packed by sim_vertex_array()
+            format = rec->state.batch_format;
+        else {
+            if (format == SIM_VERTEX_FORMAT_DEFAULT)
+                format = sim_auto_vertex_format(rec->state.batch_attrs);
+            if (format != SIM_VERTEX_FORMAT_FULL) {
+                unsigned char *data = rec->vertices.data + call->voffset;
+                sim_pack_vertices(format, data, (sim_vertex_t*)data, call->vcount);
+            }
         }
-    };
-    vbuf = sg_make_buffer(&b0);
-    sim.state.draw_call.keep_vbuf = 0;
-    
-SKIP:
-    sim.state.draw_call.bind = (sg_bindings) {
+        call->vstream = 1;
+        rec->vertices.size = call->voffset + call->vcount * sim.formats[format].stride;
+        if (call->index_count) {
+            // explicit indices take precedence over quad indexing
+            call->index_stream = 1;
+            index_type = sim_pack_indices(call);
+        } else if (rec->state.quads) {
+            ibuf = sim.quad_indices;
+            index_type = SG_INDEXTYPE_UINT16;
+            call->index_count = call->vcount / 4 * 6;
+        }
+        if (sim_context()->retain.frames && sim_recording_on_main_thread())
+            sim_retain_draw_call(call, format, &vbuf, &ibuf);
+    }
+    call->format = format;
+    call->state.primitive_type = rec->state.pip_desc.primitive_type;
+    call->state.index_type = index_type;
+    call->state.cull_mode = rec->state.pip_desc.cull_mode;
+    call->state.depth = rec->state.pip_desc.depth;
+    call->state.blend = rec->state.blend;
+    call->state.sampler.min_filter = rec->state.sampler_desc.min_filter;
+    call->state.sampler.mag_filter = rec->state.sampler_desc.mag_filter;
+    call->state.sampler.wrap_u = rec->state.sampler_desc.wrap_u;
+    call->state.sampler.wrap_v = rec->state.sampler_desc.wrap_v;
+    call->state.layer = rec->state.layer;
+    call->projection = *sim_matrix_stack_head(SIM_MATRIXMODE_PROJECTION);
+    call->texture_matrix = *sim_matrix_stack_head(SIM_MATRIXMODE_TEXTURE);
+    call->bind = (sg_bindings) {
         .vertex_buffers[0] = vbuf,
-        .vertex_buffers[1] = sg_make_buffer(&b1),
-        .fs.images[SLOT_texture_v] = sim.state.current_texture,
-        .fs.samplers = sg_make_sampler(&sim.state.sampler_desc)
+        .index_buffer = ibuf,
+        .fs.images[SLOT_texture_v] = rec->state.current_texture
     };
-    sg_range r0 = {
-        .ptr = sim.state.draw_call.instances,
-        .size = sim.state.draw_call.icount * sizeof(sim_vs_inst_t)
-    };
-    sg_update_buffer(sim.state.draw_call.bind.vertex_buffers[1], &r0);
-    memcpy(draw_call, &sim.state.draw_call, sizeof(sim_draw_call_t));
-    sim_push_command(SIM_CMD_DRAW_CALL, draw_call);
+    // sokol may only be called from the main thread, other draws are
+    // resolved when they are merged or their context is rendered
+    if (sim_recording_on_main_thread())
+        sim_resolve_draw_call(call);
+    if (ibuf.id == sim.quad_indices.id && call->vcount > MAX_QUAD_COUNT * 4) {
+        // more quads than the shared index buffer covers, split into
+        // consecutive draws that each start at their own vertex offset
+        int remaining = call->vcount;
+        int stride = sim.formats[format].stride;
+        for (int first = 1; remaining; first = 0) {
+            int count = remaining < MAX_QUAD_COUNT * 4 ? remaining : MAX_QUAD_COUNT * 4;
+            call->vcount = count;
+            call->index_count = count / 4 * 6;
+            // an uncached pipeline or sampler is destroyed after its draw,
+            // and sorting may reorder the chunks, so each gets its own
+            if (!first && sim_recording_on_main_thread()) {
+                if (!call->keep_pip)
+                    call->pip = sim_find_pipeline(call, &call->keep_pip);
+                if (!call->keep_smp)
+                    call->bind.fs.samplers[SLOT_sampler_v] = sim_find_sampler(call, &call->keep_smp);
+            }
+            sim_submit_draw_call(call, 0);
+            call->voffset += count * stride;
+            if (!call->vstream)
+                call->bind.vertex_buffer_offsets[0] += count * stride;
+            remaining -= count;
+        }
+    } else
+        sim_submit_draw_call(call, 1);
+    goto RESET;
     
 BAIL:
-    if (sim.state.draw_call.vertices) {
-        free(sim.state.draw_call.vertices);
-        sim.state.draw_call.vertices = NULL;
+    if (rec->state.in_batch) {
+        rec->vertices.size = rec->state.draw_call.voffset;
+        rec->instances.size = rec->state.draw_call.ioffset;
+        rec->indices.size = rec->state.draw_call.index_offset;
+    }
+RESET:
+    rec->state.in_batch = 0;
+    memset(&rec->state.draw_call, 0, sizeof(sim_draw_call_t));
+    memset(&rec->state.sampler_desc, 0, sizeof(sg_sampler_desc));
+}
+
+int sim_recorder_create(void) {
+    assert(!sim_thread_recorder);
+    sim_context_t *ctx = sim_context();
+    assert(ctx->recorder_count < MAX_RECORDERS);
+    sim_recorder_t *rec = calloc(1, sizeof(sim_recorder_t));
+    assert(rec);
+    ctx->recorders[ctx->recorder_count++] = rec;
+    rec->state = sim.default_state;
+    // worker streams never reach the GPU, only their CPU side is used
+    return ctx->recorder_count;
+}
+
+void sim_recorder_begin(int recorder) {
+    sim_context_t *ctx = sim_context();
+    // recorder_count may be growing on the main thread, the slot itself was
+    // filled before this recorder's handle was handed out
+    assert(!sim_thread_recorder && recorder > 0 && recorder <= MAX_RECORDERS);
+    sim_recorder_t *rec = ctx->recorders[recorder-1];
+    assert(rec && !rec->bound);
+    rec->bound = 1;
+    sim_thread_recorder = rec;
+}
+
+void sim_recorder_end(void) {
+    assert(sim_thread_recorder && !sim_thread_recorder->state.in_batch);
+    sim_flush_sprites();
+    sim_thread_recorder->bound = 0;
+    sim_thread_recorder = NULL;
+}
+
+sim_context_t* sim_context_create(void) {
+    sim_context_t *ctx = calloc(1, sizeof(sim_context_t));
+    assert(ctx);
+    ctx->main.state = sim.default_state;
+    sim_stream_init(&ctx->main.vertices, SG_BUFFERTYPE_VERTEXBUFFER, DEFAULT_VERTEX_STREAM_SIZE);
+    sim_stream_init(&ctx->main.instances, SG_BUFFERTYPE_VERTEXBUFFER, DEFAULT_INSTANCE_STREAM_SIZE);
+    sim_stream_init(&ctx->main.indices, SG_BUFFERTYPE_INDEXBUFFER, DEFAULT_INDEX_STREAM_SIZE);
+    ctx->pipeline_epoch = sim.frame_index;
+    ctx->next = sim.contexts;
+    sim.contexts = ctx;
+    return ctx;
+}
+
+void sim_context_destroy(sim_context_t *context) {
+    assert(context && context != &sim.context);
+    assert(sim_thread_context != context);
+    for (sim_context_t **link = &sim.contexts; *link; link = &(*link)->next)
+        if (*link == context) {
+            *link = context->next;
+            break;
+        }
+    sim_release_context(context);
+    free(context);
+}
+
+void sim_context_make_current(sim_context_t *context) {
+    assert(!sim_thread_recorder);
+    sim_thread_context = context == &sim.context ? NULL : context;
+}
+
+sim_context_t* sim_context_current(void) {
+    return sim_context();
+}
+
+// Renders and clears everything recorded into the context so far. The
+// default context may be rendered too, whatever is left of it still goes
+// to the window at the end of the frame.
+void sim_context_render(sim_context_t *context, int target) {
+    assert(!sim_thread_recorder && !context->main.state.in_batch);
+    sim_render_target_t *rt = sim_get_render_target(target);
+    sim_context_t *current = sim_thread_context;
+    sim_thread_context = context == &sim.context ? NULL : context;
+    sim_flush_sprites();
+    sim_thread_context = current;
+    sim_merge_recorders(context, &context->main);
+    sim_context_submit(context, &(sg_pass) {
+        .action = {
+            .colors[0] = {
+                .load_action = SG_LOADACTION_CLEAR,
+                .clear_value = context->main.state.clear_color
+            }
+        },
+        .attachments = rt->attachments
+    });
+}
+
+void sim_list_begin(void) {
+    assert(!sim_thread_recorder);
+    sim_context_t *ctx = sim_context();
+    assert(!ctx->list_recorder.active && !ctx->main.state.in_batch);
+    sim_flush_sprites();
+    sim_list_recorder_t *rec = &ctx->list_recorder;
+    rec->active = 1;
+    rec->command_start = ctx->main.commands.count;
+    rec->voffset = ctx->main.vertices.size;
+    rec->ioffset = ctx->main.instances.size;
+    rec->index_offset = ctx->main.indices.size;
+    // batches are recorded relative to the modelview the list is called with
+    hmm_mat4 *modelview = sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW);
+    rec->modelview = *modelview;
+    *modelview = HMM_Mat4d(1.f);
+    // retained buffers can be evicted from under the list
+    rec->retain_frames = ctx->retain.frames;
+    ctx->retain.frames = 0;
+}
+
+static sg_buffer make_list_buffer(sg_buffer_type type, const void *data, int size) {
+    if (!size)
+        return (sg_buffer){.id=SG_INVALID_ID};
+    sg_buffer result = sim_make_buffer(&(sg_buffer_desc) {
+        .type = type,
+        .data = (sg_range) {
+            .ptr = data,
+            .size = size
+        }
+    });
+    sim_soft_shadow(&sim.soft.buffers, result.id, data, size, 0, 0, 1);
+    return result;
+}
+
+int sim_list_end(void) {
+    assert(!sim_thread_recorder);
+    sim_context_t *ctx = sim_context();
+    assert(ctx->list_recorder.active && !ctx->main.state.in_batch);
+    sim_flush_sprites();
+    sim_list_recorder_t *rec = &ctx->list_recorder;
+    int result = 0;
+    for (int i = 0; i < sim.list_count; i++)
+        if (!sim.lists[i].commands) {
+            result = i + 1;
+            break;
+        }
+    if (!result) {
+        sim.lists = realloc(sim.lists, ++sim.list_count * sizeof(sim_list_t));
+        assert(sim.lists);
+        result = sim.list_count;
     }
-    sim.state.draw_call.vcount = 0;
-    if (sim.state.draw_call.instances) {
-        free(sim.state.draw_call.instances);
-        sim.state.draw_call.instances = NULL;
+    sim_list_t *list = &sim.lists[result-1];
+    memset(list, 0, sizeof(sim_list_t));
+
+    list->count = ctx->main.commands.count - rec->command_start;
+    list->commands = malloc((list->count ? list->count : 1) * sizeof(sim_command_t));
+    assert(list->commands);
+    memcpy(list->commands, ctx->main.commands.commands + rec->command_start, list->count * sizeof(sim_command_t));
+    list->vbuf = make_list_buffer(SG_BUFFERTYPE_VERTEXBUFFER, ctx->main.vertices.data + rec->voffset, ctx->main.vertices.size - rec->voffset);
+    list->ibuf = make_list_buffer(SG_BUFFERTYPE_INDEXBUFFER, ctx->main.indices.data + rec->index_offset, ctx->main.indices.size - rec->index_offset);
+    list->instance_count = (ctx->main.instances.size - rec->ioffset) / (int)sizeof(sim_vs_inst_t);
+    if (list->instance_count) {
+        list->instances = malloc(list->instance_count * sizeof(sim_vs_inst_t));
+        assert(list->instances);
+        memcpy(list->instances, ctx->main.instances.data + rec->ioffset, list->instance_count * sizeof(sim_vs_inst_t));
     }
-    sim.state.draw_call.icount = 0;
-    
-    sg_pipeline tmp = sim.state.draw_call.pip;
-    memset(&sim.state.draw_call, 0, sizeof(sim_draw_call_t));
-    memset(&sim.state.sampler_desc, 0, sizeof(sg_sampler_desc));
-    sim.state.draw_call.pip = tmp;
+
+    // rebase every draw onto the list's own buffers, cached pipelines are
+    // pinned for the list's lifetime and uncached ones are owned by it
+    for (int i = 0; i < list->count; i++) {
+        if (list->commands[i].type != SIM_CMD_DRAW_CALL)
+            continue;
+        sim_draw_call_t *call = &list->commands[i].draw_call;
+        if (call->vstream) {
+            call->bind.vertex_buffers[0] = list->vbuf;
+            call->bind.vertex_buffer_offsets[0] = call->voffset - rec->voffset;
+            call->vstream = 0;
+        }
+        if (call->index_stream) {
+            call->bind.index_buffer = list->ibuf;
+            call->bind.index_buffer_offset = call->index_offset - rec->index_offset;
+            call->index_stream = 0;
+        }
+        call->ioffset -= rec->ioffset;
+        sim_resolve_draw_call(call);
+        if (call->keep_pip)
+            sim_pin_pipeline(call->pip, 1);
+    }
+
+    ctx->main.commands.count = rec->command_start;
+    ctx->main.vertices.size = rec->voffset;
+    ctx->main.instances.size = rec->ioffset;
+    ctx->main.indices.size = rec->index_offset;
+    *sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW) = rec->modelview;
+    ctx->retain.frames = rec->retain_frames;
+    rec->active = 0;
+    return result;
+}
+
+static sim_list_t* sim_get_list(int list) {
+    assert(list > 0 && list <= sim.list_count);
+    sim_list_t *result = &sim.lists[list-1];
+    assert(result->commands);
+    return result;
+}
+
+// Replays under the current modelview and projection. The only CPU work
+// is one matrix multiply per recorded instance.
+void sim_call_list(int handle) {
+    sim_recorder_t *rec = sim_recorder();
+    assert(!rec->state.in_batch);
+    sim_list_t *list = sim_get_list(handle);
+    sim_flush_sprites();
+    hmm_mat4 modelview = *sim_matrix_stack_head(SIM_MATRIXMODE_MODELVIEW);
+    hmm_mat4 projection = *sim_matrix_stack_head(SIM_MATRIXMODE_PROJECTION);
+    for (int i = 0; i < list->count; i++) {
+        sim_command_t *src = &list->commands[i];
+        sim_command_t *dst = sim_push_command(src->type);
+        memcpy(dst, src, sizeof(sim_command_t));
+        if (src->type != SIM_CMD_DRAW_CALL)
+            continue;
+        sim_draw_call_t *call = &dst->draw_call;
+        call->keep_pip = 1;
+        call->keep_smp = 1;
+        call->projection = projection;
+        call->ioffset = rec->instances.size;
+        sim_vs_inst_t *inst = (sim_vs_inst_t*)sim_stream_reserve(&rec->instances, call->icount * sizeof(sim_vs_inst_t));
+        for (int j = 0; j < call->icount; j++)
+            make_vs_inst(&inst[j], HMM_MultiplyMat4(modelview, inst_matrix(&list->instances[src->draw_call.ioffset / sizeof(sim_vs_inst_t) + j])));
+        rec->instances.size += call->icount * sizeof(sim_vs_inst_t);
+        if (sim_context()->draw_order == SIM_DRAW_ORDER_SORTED)
+            call->sort_key = sim_sort_key(sim_recorder(), call);
+    }
+}
+
+// The list's resources are destroyed once every context has submitted the
+// commands that may still call it, see sim_collect_lists()
+void sim_release_list(int handle) {
+    sim_list_t *list = sim_get_list(handle);
+    if (sim.released_list_count == sim.released_list_capacity) {
+        sim.released_list_capacity = sim.released_list_capacity ? sim.released_list_capacity * 2 : 16;
+        sim.released_lists = realloc(sim.released_lists, sim.released_list_capacity * sizeof(sim_list_t));
+        assert(sim.released_lists);
+    }
+    list->released = sim.frame_index;
+    sim.released_lists[sim.released_list_count++] = *list;
+    memset(list, 0, sizeof(sim_list_t));
 }
 
 int sim_empty_texture(int width, int height) {
@@ -926,14 +4710,22 @@ int sim_empty_texture(int width, int height) {
     return sg_make_image(&desc).id;
 }
 
+// sokol may only be queried from the main thread, recorders bound on other
+// threads (including the pipelined loop) can only check for a handle
+static int sim_texture_valid(sg_image image) {
+    if (sim_thread_recorder)
+        return image.id != SG_INVALID_ID;
+    return sg_query_image_state(image) == SG_RESOURCESTATE_VALID;
+}
+
 void sim_push_texture(int texture) {
     sg_image tmp = {.id = texture};
-    assert(sg_query_image_state(tmp) == SG_RESOURCESTATE_VALID);
-    sim.state.current_texture = tmp;
+    assert(sim_texture_valid(tmp));
+    sim_recorder()->state.current_texture = tmp;
 }
 
 void sim_pop_texture(void) {
-    memset(&sim.state.current_texture, 0, sizeof(sg_image));
+    memset(&sim_recorder()->state.current_texture, 0, sizeof(sg_image));
 }
 
 static int does_file_exist(const char *path) {
@@ -1032,11 +4824,221 @@ int sim_load_texture_memory(unsigned char *data, int data_size) {
             .size = w * h * sizeof(int)
         }
     };
-    sg_update_image(texture, &desc);
+    sim_update_image(texture, &desc);
+    sim_soft_shadow(&sim.soft.images, texture.id, tmp, w * h * sizeof(int), w, h, 1);
     free(tmp);
     return texture.id;
 }
 
+int sim_atlas_create(int width, int height, int padding) {
+    assert(width > 0 && height > 0);
+    int result = 0;
+    for (int i = 0; i < sim.atlas_count; i++)
+        if (!sim.atlases[i].width) {
+            result = i + 1;
+            break;
+        }
+    if (!result) {
+        sim.atlases = realloc(sim.atlases, ++sim.atlas_count * sizeof(sim_atlas_t));
+        assert(sim.atlases);
+        result = sim.atlas_count;
+    }
+    sim_atlas_t *atlas = &sim.atlases[result-1];
+    memset(atlas, 0, sizeof(sim_atlas_t));
+    atlas->width = width;
+    atlas->height = height;
+    atlas->padding = padding < 0 ? DEFAULT_ATLAS_PADDING : padding;
+    return result;
+}
+
+static sim_atlas_t* sim_get_atlas(int atlas) {
+    assert(atlas > 0 && atlas <= sim.atlas_count);
+    sim_atlas_t *result = &sim.atlases[atlas-1];
+    assert(result->width);
+    return result;
+}
+
+static sim_atlas_page_t* sim_atlas_new_page(sim_atlas_t *atlas) {
+    atlas->pages = realloc(atlas->pages, ++atlas->page_count * sizeof(sim_atlas_page_t));
+    assert(atlas->pages);
+    sim_atlas_page_t *page = &atlas->pages[atlas->page_count-1];
+    memset(page, 0, sizeof(sim_atlas_page_t));
+    page->image = sg_make_image(&(sg_image_desc) {
+        .width = atlas->width,
+        .height = atlas->height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .usage = SG_USAGE_DYNAMIC
+    });
+    page->pixels = calloc(atlas->width * atlas->height, sizeof(int));
+    // the skyline never has more segments than the page has columns, plus
+    // one while an insert is being trimmed
+    page->nodes = malloc((atlas->width + 1) * sizeof(sim_skyline_node_t));
+    assert(page->pixels && page->nodes);
+    sim_soft_shadow(&sim.soft.images, page->image.id, page->pixels, atlas->width * atlas->height * sizeof(int), atlas->width, atlas->height, 0);
+    page->nodes[0] = (sim_skyline_node_t){0, 0, atlas->width};
+    page->node_count = 1;
+    return page;
+}
+
+// Returns the lowest y a w*h rectangle fits at when its left edge sits on
+// skyline node index, or -1 if it doesn't fit there.
+static int skyline_fit(sim_atlas_t *atlas, sim_atlas_page_t *page, int index, int w, int h) {
+    int x = page->nodes[index].x;
+    if (x + w > atlas->width)
+        return -1;
+    int y = 0, remaining = w;
+    for (int i = index; remaining > 0; i++) {
+        if (page->nodes[i].y > y)
+            y = page->nodes[i].y;
+        if (y + h > atlas->height)
+            return -1;
+        remaining -= page->nodes[i].width;
+    }
+    return y;
+}
+
+// Bottom-left skyline packing, picks the position that keeps the top of
+// the rectangle lowest, breaking ties on the narrowest segment.
+static int skyline_insert(sim_atlas_t *atlas, sim_atlas_page_t *page, int w, int h, int *out_x, int *out_y) {
+    int best = -1, best_top = INT_MAX, best_width = INT_MAX, best_y = 0;
+    for (int i = 0; i < page->node_count; i++) {
+        int y = skyline_fit(atlas, page, i, w, h);
+        if (y < 0)
+            continue;
+        if (y + h < best_top || (y + h == best_top && page->nodes[i].width < best_width)) {
+            best = i;
+            best_top = y + h;
+            best_width = page->nodes[i].width;
+            best_y = y;
+        }
+    }
+    if (best < 0)
+        return 0;
+
+    sim_skyline_node_t node = {page->nodes[best].x, best_y + h, w};
+    memmove(&page->nodes[best+1], &page->nodes[best], (page->node_count - best) * sizeof(sim_skyline_node_t));
+    page->nodes[best] = node;
+    page->node_count++;
+    // trim or drop the segments now covered by the new one
+    for (int i = best + 1; i < page->node_count; i++) {
+        sim_skyline_node_t *prev = &page->nodes[i-1];
+        sim_skyline_node_t *cur = &page->nodes[i];
+        int shrink = prev->x + prev->width - cur->x;
+        if (shrink <= 0)
+            break;
+        cur->x += shrink;
+        cur->width -= shrink;
+        if (cur->width > 0)
+            break;
+        memmove(cur, cur + 1, (page->node_count - i - 1) * sizeof(sim_skyline_node_t));
+        page->node_count--;
+        i--;
+    }
+    for (int i = 0; i < page->node_count - 1; i++)
+        if (page->nodes[i].y == page->nodes[i+1].y) {
+            page->nodes[i].width += page->nodes[i+1].width;
+            memmove(&page->nodes[i+1], &page->nodes[i+2], (page->node_count - i - 2) * sizeof(sim_skyline_node_t));
+            page->node_count--;
+            i--;
+        }
+    *out_x = node.x;
+    *out_y = best_y;
+    return 1;
+}
+
+int sim_atlas_add_pixels(int handle, const int *pixels, int width, int height) {
+    assert(pixels && width > 0 && height > 0);
+    sim_atlas_t *atlas = sim_get_atlas(handle);
+    int pad = atlas->padding;
+    int w = width + pad * 2, h = height + pad * 2;
+    if (w > atlas->width || h > atlas->height)
+        return 0;
+
+    int x = 0, y = 0, page_index = -1;
+    for (int i = 0; i < atlas->page_count; i++)
+        if (skyline_insert(atlas, &atlas->pages[i], w, h, &x, &y)) {
+            page_index = i;
+            break;
+        }
+    if (page_index < 0) {
+        int packed = skyline_insert(atlas, sim_atlas_new_page(atlas), w, h, &x, &y);
+        assert(packed);
+        page_index = atlas->page_count - 1;
+    }
+
+    // the padding repeats the image's edge pixels so filtering at the
+    // border never samples a neighbour
+    sim_atlas_page_t *page = &atlas->pages[page_index];
+    for (int row = 0; row < h; row++) {
+        int sy = row - pad;
+        sy = sy < 0 ? 0 : sy >= height ? height - 1 : sy;
+        int *dst = page->pixels + (y + row) * atlas->width + x;
+        for (int col = 0; col < w; col++) {
+            int sx = col - pad;
+            sx = sx < 0 ? 0 : sx >= width ? width - 1 : sx;
+            dst[col] = pixels[sy * width + sx];
+        }
+    }
+    page->dirty = 1;
+
+    if (atlas->region_count == atlas->region_capacity) {
+        atlas->region_capacity = atlas->region_capacity ? atlas->region_capacity * 2 : 64;
+        atlas->regions = realloc(atlas->regions, atlas->region_capacity * sizeof(sim_atlas_region_t));
+        assert(atlas->regions);
+    }
+    sim_atlas_region_t *region = &atlas->regions[atlas->region_count++];
+    region->page = page_index;
+    region->u0 = (float)(x + pad) / atlas->width;
+    region->v0 = (float)(y + pad) / atlas->height;
+    region->u1 = (float)(x + pad + width) / atlas->width;
+    region->v1 = (float)(y + pad + height) / atlas->height;
+    return atlas->region_count;
+}
+
+int sim_atlas_add(int atlas, unsigned char *data, int data_size) {
+    int w, h;
+    int *tmp = load_texture_data(data, data_size, &w, &h);
+    assert(tmp && w && h);
+    int result = sim_atlas_add_pixels(atlas, tmp, w, h);
+    free(tmp);
+    return result;
+}
+
+static sim_atlas_region_t* sim_get_atlas_region(sim_atlas_t *atlas, int region) {
+    assert(region > 0 && region <= atlas->region_count);
+    return &atlas->regions[region-1];
+}
+
+int sim_atlas_texture(int atlas, int region) {
+    sim_atlas_t *a = sim_get_atlas(atlas);
+    return a->pages[sim_get_atlas_region(a, region)->page].image.id;
+}
+
+void sim_atlas_uv(int atlas, int region, float *u0, float *v0, float *u1, float *v1) {
+    sim_atlas_region_t *r = sim_get_atlas_region(sim_get_atlas(atlas), region);
+    if (u0)
+        *u0 = r->u0;
+    if (v0)
+        *v0 = r->v0;
+    if (u1)
+        *u1 = r->u1;
+    if (v1)
+        *v1 = r->v1;
+}
+
+void sim_atlas_destroy(int handle) {
+    sim_atlas_t *atlas = sim_get_atlas(handle);
+    for (int i = 0; i < atlas->page_count; i++) {
+        sim_soft_forget(&sim.soft.images, atlas->pages[i].image.id);
+        sg_destroy_image(atlas->pages[i].image);
+        free(atlas->pages[i].pixels);
+        free(atlas->pages[i].nodes);
+    }
+    free(atlas->pages);
+    free(atlas->regions);
+    memset(atlas, 0, sizeof(sim_atlas_t));
+}
+
 static void set_filter(sg_filter *dst, int val) {
     switch (val) {
         default:
@@ -1052,9 +5054,10 @@ static void set_filter(sg_filter *dst, int val) {
 }
 
 void sim_set_texture_filter(int min, int mag) {
-    assert(sg_query_image_state(sim.state.current_texture) == SG_RESOURCESTATE_VALID);
-    set_filter(&sim.state.sampler_desc.min_filter, min);
-    set_filter(&sim.state.sampler_desc.mag_filter, mag);
+    sim_recorder_t *rec = sim_recorder();
+    assert(sim_texture_valid(rec->state.current_texture));
+    set_filter(&rec->state.sampler_desc.min_filter, min);
+    set_filter(&rec->state.sampler_desc.mag_filter, mag);
 }
 
 static void set_wrap(sg_wrap *dst, int val) {
@@ -1073,37 +5076,191 @@ static void set_wrap(sg_wrap *dst, int val) {
 }
 
 void sim_set_texture_wrap(int wrap_u, int wrap_v) {
-    assert(sg_query_image_state(sim.state.current_texture) == SG_RESOURCESTATE_VALID);
-    set_wrap(&sim.state.sampler_desc.wrap_u, wrap_u);
-    set_wrap(&sim.state.sampler_desc.wrap_v, wrap_v);
+    sim_recorder_t *rec = sim_recorder();
+    assert(sim_texture_valid(rec->state.current_texture));
+    set_wrap(&rec->state.sampler_desc.wrap_u, wrap_u);
+    set_wrap(&rec->state.sampler_desc.wrap_v, wrap_v);
 }
 
 void sim_release_texture(int texture) {
     sg_image tmp = {.id = texture};
+    sim_soft_forget(&sim.soft.images, tmp.id);
     if (sg_query_image_state(tmp) == SG_RESOURCESTATE_VALID)
         sg_destroy_image(tmp);
 }
 
+static int sim_new_buffer(void) {
+    for (int i = 0; i < sim.buffer_count; i++)
+        if (sim.buffers[i].vbuf.id == SG_INVALID_ID)
+            return i + 1;
+    sim.buffers = realloc(sim.buffers, ++sim.buffer_count * sizeof(sim_buffer_t));
+    assert(sim.buffers);
+    return sim.buffer_count;
+}
+
+// Welds byte-identical vertices, writing the unique ones to out and the
+// unique index of every input vertex to remap. Returns the unique count.
+static int weld_vertices(const sim_vertex_t *vertices, int count, sim_vertex_t *out, uint32_t *remap) {
+    int table_size = next_pow2(count * 2);
+    int *table = malloc(table_size * sizeof(int));
+    assert(table);
+    memset(table, -1, table_size * sizeof(int));
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        int slot = (int)(sim_hash(&vertices[i], sizeof(sim_vertex_t)) & (table_size - 1));
+        while (table[slot] != -1 && memcmp(&out[table[slot]], &vertices[i], sizeof(sim_vertex_t)))
+            slot = (slot + 1) & (table_size - 1);
+        if (table[slot] == -1) {
+            table[slot] = unique;
+            out[unique++] = vertices[i];
+        }
+        remap[i] = table[slot];
+    }
+    free(table);
+    return unique;
+}
+
 int sim_store_buffer(void) {
-    sg_buffer_desc desc = {
+    assert(!sim_thread_recorder);
+    sim_recorder_t *rec = sim_recorder();
+    sim_draw_call_t *call = &rec->state.draw_call;
+    assert(rec->state.in_batch && call->vcount && !rec->state.batch_format);
+    const sim_vertex_t *vertices = (const sim_vertex_t*)(rec->vertices.data + call->voffset);
+    sim_vertex_t *unique = malloc(call->vcount * sizeof(sim_vertex_t));
+    uint32_t *remap = malloc(call->vcount * sizeof(uint32_t));
+    assert(unique && remap);
+    int ucount = weld_vertices(vertices, call->vcount, unique, remap);
+
+    // explicit batch indices are remapped, otherwise every vertex is drawn in
+    // order, or as two triangles per 4 vertices for quads
+    static const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+    int quads = rec->state.quads && !call->index_count;
+    int index_count = call->index_count ? call->index_count : quads ? call->vcount / 4 * 6 : call->vcount;
+    const uint32_t *src = call->index_count ? (const uint32_t*)(rec->indices.data + call->index_offset) : NULL;
+    sg_index_type index_type = ucount <= 65536 ? SG_INDEXTYPE_UINT16 : SG_INDEXTYPE_UINT32;
+    int index_size = index_type == SG_INDEXTYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    void *indices = malloc(index_count * index_size);
+    assert(indices);
+    for (int i = 0; i < index_count; i++) {
+        uint32_t index = src ? src[i] : quads ? (uint32_t)(i / 6 * 4 + quad[i % 6]) : (uint32_t)i;
+        assert(index < (uint32_t)call->vcount);
+        if (index_type == SG_INDEXTYPE_UINT16)
+            ((uint16_t*)indices)[i] = (uint16_t)remap[index];
+        else
+            ((uint32_t*)indices)[i] = remap[index];
+    }
+
+    int result = sim_new_buffer();
+    sim_buffer_t *buffer = &sim.buffers[result-1];
+    buffer->vbuf = sim_make_buffer(&(sg_buffer_desc) {
         .data = (sg_range) {
-            .ptr = sim.state.draw_call.vertices,
-            .size = sim.state.draw_call.vcount * sizeof(sim_vertex_t)
+            .ptr = unique,
+            .size = ucount * sizeof(sim_vertex_t)
         }
-    };
-    sg_buffer result = sg_make_buffer(&desc);
-    assert(sg_query_buffer_state(result) == SG_RESOURCESTATE_VALID);
-    return result.id;
+    });
+    buffer->ibuf = sim_make_buffer(&(sg_buffer_desc) {
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .data = (sg_range) {
+            .ptr = indices,
+            .size = index_count * index_size
+        }
+    });
+    sim_soft_shadow(&sim.soft.buffers, buffer->vbuf.id, unique, ucount * sizeof(sim_vertex_t), 0, 0, 1);
+    sim_soft_shadow(&sim.soft.buffers, buffer->ibuf.id, indices, index_count * index_size, 0, 0, 1);
+    buffer->vcount = ucount;
+    buffer->index_count = index_count;
+    buffer->index_type = index_type;
+    buffer->format = SIM_VERTEX_FORMAT_FULL;
+    assert(sg_query_buffer_state(buffer->vbuf) == SG_RESOURCESTATE_VALID);
+    free(unique);
+    free(remap);
+    free(indices);
+    return result;
+}
+
+int sim_store_vertex_array(const void *data, int count, int stride, int layout) {
+    assert(!sim_thread_recorder);
+    assert(data && count > 0);
+    int format = vertex_array_format(layout);
+    int size = sim.formats[format].stride;
+    if (!stride)
+        stride = size;
+    assert(stride >= size);
+    const void *ptr = data;
+    void *tmp = NULL;
+    if (stride != size) {
+        tmp = malloc(count * size);
+        assert(tmp);
+        copy_strided(tmp, data, count, size, stride);
+        ptr = tmp;
+    }
+
+    int result = sim_new_buffer();
+    sim_buffer_t *buffer = &sim.buffers[result-1];
+    memset(buffer, 0, sizeof(sim_buffer_t));
+    buffer->vbuf = sim_make_buffer(&(sg_buffer_desc) {
+        .data = (sg_range) {
+            .ptr = ptr,
+            .size = count * size
+        }
+    });
+    sim_soft_shadow(&sim.soft.buffers, buffer->vbuf.id, ptr, count * size, 0, 0, 1);
+    buffer->vcount = count;
+    buffer->index_type = SG_INDEXTYPE_NONE;
+    buffer->format = format;
+    assert(sg_query_buffer_state(buffer->vbuf) == SG_RESOURCESTATE_VALID);
+    if (tmp)
+        free(tmp);
+    return result;
 }
 
 void sim_load_buffer(int buffer) {
-    sg_buffer buf = {.id = buffer};
-    assert(sg_query_buffer_state(buf) == SG_RESOURCESTATE_VALID);
-    sim.state.current_buffer = buf;
+    sim_get_buffer(buffer);
+    sim_recorder()->state.current_buffer = buffer;
 }
 
 void sim_release_buffer(int buffer) {
-    sg_buffer buf = {.id = buffer};
-    if (sg_query_buffer_state(buf) == SG_RESOURCESTATE_VALID)
-        sg_destroy_buffer(buf);
+    if (buffer <= 0 || buffer > sim.buffer_count)
+        return;
+    sim_buffer_t *stored = &sim.buffers[buffer-1];
+    sim_soft_forget(&sim.soft.buffers, stored->vbuf.id);
+    sim_soft_forget(&sim.soft.buffers, stored->ibuf.id);
+    if (sg_query_buffer_state(stored->vbuf) == SG_RESOURCESTATE_VALID)
+        sim_destroy_buffer(stored->vbuf);
+    if (sg_query_buffer_state(stored->ibuf) == SG_RESOURCESTATE_VALID)
+        sim_destroy_buffer(stored->ibuf);
+    memset(stored, 0, sizeof(sim_buffer_t));
+}
+
+void sim_reserve_vertices(int count) {
+    assert(count >= 0);
+    sim_stream_reserve(&sim_recorder()->vertices, count * sizeof(sim_vertex_t));
+}
+
+// These describe the context's GPU stream, which worker and pipelined
+// recorders only feed through their CPU side, so they never read those
+int sim_vertex_high_water_mark(void) {
+    sim_recorder_t *rec = &sim_context()->main;
+    int count = sim_stream_vertex_count(rec);
+    return count > rec->vertex_high_water ? count : rec->vertex_high_water;
+}
+
+int sim_vertex_stream_used(void) {
+    return sim_context()->main.vertices.used;
+}
+
+int sim_vertex_stream_capacity(void) {
+    return sim_context()->main.vertices.gpu_capacity;
+}
+
+int sim_pipeline_cache_hits(void) {
+    return sim.pipelines.hits;
+}
+
+int sim_pipeline_cache_misses(void) {
+    return sim.pipelines.misses;
+}
+
+sim_frame_stats_t sim_frame_stats(void) {
+    return sim.last_stats;
 }
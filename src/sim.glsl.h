@@ -36,6 +36,84 @@
             Image Sampler Pair 'texture_v_sampler_v':
                 Image: texture_v
                 Sampler: sampler_v
+    Shader program: 'sim_uv':
+        Get shader desc: sim_uv_shader_desc(sg_query_backend());
+        Vertex shader: vs_uv
+            Attributes:
+                ATTR_vs_uv_position => 0
+                ATTR_vs_uv_texcoord => 1
+                ATTR_vs_uv_color_v => 2
+                ATTR_vs_uv_inst_mat_x => 3
+                ATTR_vs_uv_inst_mat_y => 4
+                ATTR_vs_uv_inst_mat_z => 5
+                ATTR_vs_uv_inst_mat_w => 6
+            Uniform block 'vs_params':
+                C struct: vs_params_t
+                Bind slot: SLOT_vs_params => 0
+        Fragment shader: fs
+            Image 'texture_v':
+                Image type: SG_IMAGETYPE_2D
+                Sample type: SG_IMAGESAMPLETYPE_FLOAT
+                Multisampled: false
+                Bind slot: SLOT_texture_v => 0
+            Sampler 'sampler_v':
+                Type: SG_SAMPLERTYPE_FILTERING
+                Bind slot: SLOT_sampler_v => 0
+            Image Sampler Pair 'texture_v_sampler_v':
+                Image: texture_v
+                Sampler: sampler_v
+    Shader program: 'sim_col':
+        Get shader desc: sim_col_shader_desc(sg_query_backend());
+        Vertex shader: vs_col
+            Attributes:
+                ATTR_vs_col_position => 0
+                ATTR_vs_col_color_v => 1
+                ATTR_vs_col_inst_mat_x => 2
+                ATTR_vs_col_inst_mat_y => 3
+                ATTR_vs_col_inst_mat_z => 4
+                ATTR_vs_col_inst_mat_w => 5
+            Uniform block 'vs_params':
+                C struct: vs_params_t
+                Bind slot: SLOT_vs_params => 0
+        Fragment shader: fs
+            Image 'texture_v':
+                Image type: SG_IMAGETYPE_2D
+                Sample type: SG_IMAGESAMPLETYPE_FLOAT
+                Multisampled: false
+                Bind slot: SLOT_texture_v => 0
+            Sampler 'sampler_v':
+                Type: SG_SAMPLERTYPE_FILTERING
+                Bind slot: SLOT_sampler_v => 0
+            Image Sampler Pair 'texture_v_sampler_v':
+                Image: texture_v
+                Sampler: sampler_v
+    Shader program: 'sim_oct':
+        Get shader desc: sim_oct_shader_desc(sg_query_backend());
+        Vertex shader: vs_oct
+            Attributes:
+                ATTR_vs_oct_position => 0
+                ATTR_vs_oct_texcoord => 1
+                ATTR_vs_oct_normal_oct => 2
+                ATTR_vs_oct_color_v => 3
+                ATTR_vs_oct_inst_mat_x => 4
+                ATTR_vs_oct_inst_mat_y => 5
+                ATTR_vs_oct_inst_mat_z => 6
+                ATTR_vs_oct_inst_mat_w => 7
+            Uniform block 'vs_params':
+                C struct: vs_params_t
+                Bind slot: SLOT_vs_params => 0
+        Fragment shader: fs
+            Image 'texture_v':
+                Image type: SG_IMAGETYPE_2D
+                Sample type: SG_IMAGESAMPLETYPE_FLOAT
+                Multisampled: false
+                Bind slot: SLOT_texture_v => 0
+            Sampler 'sampler_v':
+                Type: SG_SAMPLERTYPE_FILTERING
+                Bind slot: SLOT_sampler_v => 0
+            Image Sampler Pair 'texture_v_sampler_v':
+                Image: texture_v
+                Sampler: sampler_v
 */
 #if !defined(SOKOL_GFX_INCLUDED)
 #error "Please include sokol_gfx.h before sim.glsl.h"
@@ -55,6 +133,27 @@
 #define ATTR_vs_inst_mat_y (5)
 #define ATTR_vs_inst_mat_z (6)
 #define ATTR_vs_inst_mat_w (7)
+#define ATTR_vs_uv_position (0)
+#define ATTR_vs_uv_texcoord (1)
+#define ATTR_vs_uv_color_v (2)
+#define ATTR_vs_uv_inst_mat_x (3)
+#define ATTR_vs_uv_inst_mat_y (4)
+#define ATTR_vs_uv_inst_mat_z (5)
+#define ATTR_vs_uv_inst_mat_w (6)
+#define ATTR_vs_col_position (0)
+#define ATTR_vs_col_color_v (1)
+#define ATTR_vs_col_inst_mat_x (2)
+#define ATTR_vs_col_inst_mat_y (3)
+#define ATTR_vs_col_inst_mat_z (4)
+#define ATTR_vs_col_inst_mat_w (5)
+#define ATTR_vs_oct_position (0)
+#define ATTR_vs_oct_texcoord (1)
+#define ATTR_vs_oct_normal_oct (2)
+#define ATTR_vs_oct_color_v (3)
+#define ATTR_vs_oct_inst_mat_x (4)
+#define ATTR_vs_oct_inst_mat_y (5)
+#define ATTR_vs_oct_inst_mat_z (6)
+#define ATTR_vs_oct_inst_mat_w (7)
 #define SLOT_vs_params (0)
 #define SLOT_texture_v (0)
 #define SLOT_sampler_v (0)
@@ -104,22 +203,33 @@ SOKOL_SHDC_ALIGN(16) typedef struct vs_params_t {
         return float4x4(float4(x.x, y.x, z.x, w.x), float4(x.y, y.y, z.y, w.y), float4(x.z, y.z, z.z, w.z), float4(x.w, y.w, z.w, w.w));
     }
 
-    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _102 [[buffer(0)]])
+    static inline __attribute__((always_inline))
+    void emit(thread const float4& position, thread const float3& normal, thread const float2& texcoord, thread const float4& color, thread float4& inst_mat_x, thread float4& inst_mat_y, thread float4& inst_mat_z, thread float4& inst_mat_w, thread float4& gl_Position, constant vs_params& _120, thread float4& out_texcoord, thread float3& out_normal, thread float4& out_color)
+    {
+        float4 param = inst_mat_x;
+        float4 param_1 = inst_mat_y;
+        float4 param_2 = inst_mat_z;
+        float4 param_3 = inst_mat_w;
+        float4x4 modelview = make_matrix(param, param_1, param_2, param_3);
+        gl_Position = (_120.projection * modelview) * position;
+        out_texcoord = _120.texture_matrix * float4(texcoord, 0.0, 1.0);
+        out_normal = normal;
+        out_color = color;
+    }
+
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _120 [[buffer(0)]])
     {
         main0_out out = {};
-        float4 param = in.inst_mat_x;
-        float4 param_1 = in.inst_mat_y;
-        float4 param_2 = in.inst_mat_z;
-        float4 param_3 = in.inst_mat_w;
-        out.gl_Position = (_102.projection * make_matrix(param, param_1, param_2, param_3)) * in.position;
-        out.out_texcoord = _102.texture_matrix * float4(in.texcoord, 0.0, 1.0);
-        out.out_normal = in.normal;
-        out.out_color = in.color_v;
+        float4 param = in.position;
+        float3 param_1 = in.normal;
+        float2 param_2 = in.texcoord;
+        float4 param_3 = in.color_v;
+        emit(param, param_1, param_2, param_3, in.inst_mat_x, in.inst_mat_y, in.inst_mat_z, in.inst_mat_w, out.gl_Position, _120, out.out_texcoord, out.out_normal, out.out_color);
         return out;
     }
 
 */
-static const uint8_t vs_source_metal_macos[1535] = {
+static const uint8_t vs_source_metal_macos[2259] = {
     0x23,0x70,0x72,0x61,0x67,0x6d,0x61,0x20,0x63,0x6c,0x61,0x6e,0x67,0x20,0x64,0x69,
     0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x20,0x69,0x67,0x6e,0x6f,0x72,0x65,0x64,
     0x20,0x22,0x2d,0x57,0x6d,0x69,0x73,0x73,0x69,0x6e,0x67,0x2d,0x70,0x72,0x6f,0x74,
@@ -183,39 +293,746 @@ static const uint8_t vs_source_metal_macos[1535] = {
     0x34,0x28,0x78,0x2e,0x7a,0x2c,0x20,0x79,0x2e,0x7a,0x2c,0x20,0x7a,0x2e,0x7a,0x2c,
     0x20,0x77,0x2e,0x7a,0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,
     0x77,0x2c,0x20,0x79,0x2e,0x77,0x2c,0x20,0x7a,0x2e,0x77,0x2c,0x20,0x77,0x2e,0x77,
-    0x29,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,
-    0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,
-    0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,
-    0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,
-    0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,0x30,0x32,
-    0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,
-    0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
-    0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
-    0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,0x2e,
-    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x3b,0x0a,0x20,0x20,0x20,0x20,
-    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,
-    0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x3b,0x0a,
+    0x29,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x69,0x6e,
+    0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,0x79,0x73,0x5f,0x69,0x6e,0x6c,0x69,0x6e,
+    0x65,0x29,0x29,0x0a,0x76,0x6f,0x69,0x64,0x20,0x65,0x6d,0x69,0x74,0x28,0x74,0x68,
+    0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x26,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x74,0x68,0x72,
+    0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,
+    0x26,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,
+    0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x26,0x20,0x74,
+    0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x63,0x6f,
+    0x6c,0x6f,0x72,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x2c,0x20,
+    0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,
+    0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,
+    0x61,0x74,0x5f,0x7a,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,
+    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x63,0x6f,0x6e,
+    0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,
+    0x20,0x5f,0x31,0x32,0x30,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,
+    0x72,0x64,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x33,0x26,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x74,
+    0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x6f,0x75,
+    0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,0x20,0x69,
+    0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x20,0x3d,0x20,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x20,0x3d,
+    0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x76,
+    0x69,0x65,0x77,0x20,0x3d,0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,
+    0x78,0x28,0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,
+    0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,
+    0x5f,0x33,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,
+    0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x28,0x5f,0x31,0x32,0x30,0x2e,0x70,0x72,0x6f,
+    0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x20,0x2a,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x76,
+    0x69,0x65,0x77,0x29,0x20,0x2a,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,
+    0x64,0x20,0x3d,0x20,0x5f,0x31,0x32,0x30,0x2e,0x74,0x65,0x78,0x74,0x75,0x72,0x65,
+    0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x28,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,
+    0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,
+    0x72,0x6d,0x61,0x6c,0x20,0x3d,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x63,
+    0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,
+    0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,
+    0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,
+    0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,
+    0x32,0x30,0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,
+    0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,
+    0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,0x3d,0x20,0x69,
+    0x6e,0x2e,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x33,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,
+    0x20,0x69,0x6e,0x2e,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x20,0x3d,
+    0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,
+    0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x65,0x6d,0x69,0x74,0x28,0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,
+    0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,
+    0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,
+    0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,
+    0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,
+    0x6d,0x61,0x74,0x5f,0x7a,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,
+    0x61,0x74,0x5f,0x77,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x5f,0x31,0x32,0x30,0x2c,0x20,0x6f,0x75,0x74,
+    0x2e,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x6f,
+    0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x6f,
+    0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x29,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,
+    0x0a,0x0a,0x00,
+};
+/*
+    #pragma clang diagnostic ignored "-Wmissing-prototypes"
+
+    #include <metal_stdlib>
+    #include <simd/simd.h>
+
+    using namespace metal;
+
+    struct vs_params
+    {
+        float4x4 texture_matrix;
+        float4x4 projection;
+    };
+
+    struct main0_out
+    {
+        float4 out_texcoord [[user(locn0)]];
+        float3 out_normal [[user(locn1)]];
+        float4 out_color [[user(locn2)]];
+        float4 gl_Position [[position]];
+    };
+
+    struct main0_in
+    {
+        float4 position [[attribute(0)]];
+        float2 texcoord [[attribute(1)]];
+        float4 color_v [[attribute(2)]];
+        float4 inst_mat_x [[attribute(3)]];
+        float4 inst_mat_y [[attribute(4)]];
+        float4 inst_mat_z [[attribute(5)]];
+        float4 inst_mat_w [[attribute(6)]];
+    };
+
+    static inline __attribute__((always_inline))
+    float4x4 make_matrix(thread const float4& x, thread const float4& y, thread const float4& z, thread const float4& w)
+    {
+        return float4x4(float4(x.x, y.x, z.x, w.x), float4(x.y, y.y, z.y, w.y), float4(x.z, y.z, z.z, w.z), float4(x.w, y.w, z.w, w.w));
+    }
+
+    static inline __attribute__((always_inline))
+    void emit(thread const float4& position, thread const float3& normal, thread const float2& texcoord, thread const float4& color, thread float4& inst_mat_x, thread float4& inst_mat_y, thread float4& inst_mat_z, thread float4& inst_mat_w, thread float4& gl_Position, constant vs_params& _120, thread float4& out_texcoord, thread float3& out_normal, thread float4& out_color)
+    {
+        float4 param = inst_mat_x;
+        float4 param_1 = inst_mat_y;
+        float4 param_2 = inst_mat_z;
+        float4 param_3 = inst_mat_w;
+        float4x4 modelview = make_matrix(param, param_1, param_2, param_3);
+        gl_Position = (_120.projection * modelview) * position;
+        out_texcoord = _120.texture_matrix * float4(texcoord, 0.0, 1.0);
+        out_normal = normal;
+        out_color = color;
+    }
+
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _120 [[buffer(0)]])
+    {
+        main0_out out = {};
+        float4 param = in.position;
+        float3 param_1 = float3(0.0);
+        float2 param_2 = in.texcoord;
+        float4 param_3 = in.color_v;
+        emit(param, param_1, param_2, param_3, in.inst_mat_x, in.inst_mat_y, in.inst_mat_z, in.inst_mat_w, out.gl_Position, _120, out.out_texcoord, out.out_normal, out.out_color);
+        return out;
+    }
+
+*/
+static const uint8_t vs_uv_source_metal_macos[2225] = {
+    0x23,0x70,0x72,0x61,0x67,0x6d,0x61,0x20,0x63,0x6c,0x61,0x6e,0x67,0x20,0x64,0x69,
+    0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x20,0x69,0x67,0x6e,0x6f,0x72,0x65,0x64,
+    0x20,0x22,0x2d,0x57,0x6d,0x69,0x73,0x73,0x69,0x6e,0x67,0x2d,0x70,0x72,0x6f,0x74,
+    0x6f,0x74,0x79,0x70,0x65,0x73,0x22,0x0a,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,
+    0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,
+    0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,
+    0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,
+    0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,
+    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
+    0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,
+    0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x70,0x72,
+    0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,
+    0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,
+    0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x33,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,
+    0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,
+    0x6e,0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,
+    0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,
+    0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,
+    0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,
+    0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,
+    0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x32,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x33,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x34,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x35,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x36,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x69,0x6e,
+    0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,0x79,0x73,0x5f,0x69,0x6e,0x6c,0x69,0x6e,
+    0x65,0x29,0x29,0x0a,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x61,0x6b,
+    0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x28,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x78,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x79,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x7a,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x77,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x72,
+    0x65,0x74,0x75,0x72,0x6e,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x28,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x78,0x2c,0x20,0x79,0x2e,0x78,0x2c,0x20,
+    0x7a,0x2e,0x78,0x2c,0x20,0x77,0x2e,0x78,0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x28,0x78,0x2e,0x79,0x2c,0x20,0x79,0x2e,0x79,0x2c,0x20,0x7a,0x2e,0x79,0x2c,
+    0x20,0x77,0x2e,0x79,0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,
+    0x7a,0x2c,0x20,0x79,0x2e,0x7a,0x2c,0x20,0x7a,0x2e,0x7a,0x2c,0x20,0x77,0x2e,0x7a,
+    0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x77,0x2c,0x20,0x79,
+    0x2e,0x77,0x2c,0x20,0x7a,0x2e,0x77,0x2c,0x20,0x77,0x2e,0x77,0x29,0x29,0x3b,0x0a,
+    0x7d,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,
+    0x20,0x5f,0x5f,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,
+    0x61,0x6c,0x77,0x61,0x79,0x73,0x5f,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,
+    0x76,0x6f,0x69,0x64,0x20,0x65,0x6d,0x69,0x74,0x28,0x74,0x68,0x72,0x65,0x61,0x64,
+    0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x70,
+    0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x26,0x20,0x6e,0x6f,
+    0x72,0x6d,0x61,0x6c,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,
+    0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x26,0x20,0x74,0x65,0x78,0x63,0x6f,
+    0x6f,0x72,0x64,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,
+    0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x2c,0x20,0x74,0x68,0x72,0x65,
+    0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,
+    0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,
+    0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,
+    0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x2c,0x20,0x74,0x68,0x72,
+    0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x67,0x6c,0x5f,0x50,
+    0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,
+    0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,
+    0x30,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x26,0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,
+    0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x26,0x20,0x6f,
+    0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,
+    0x6c,0x6f,0x72,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,
+    0x61,0x74,0x5f,0x78,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,
+    0x6d,0x61,0x74,0x5f,0x79,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,
+    0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x73,
+    0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x20,
+    0x3d,0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x28,0x70,0x61,
+    0x72,0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,
+    0x72,0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x29,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
+    0x20,0x3d,0x20,0x28,0x5f,0x31,0x32,0x30,0x2e,0x70,0x72,0x6f,0x6a,0x65,0x63,0x74,
+    0x69,0x6f,0x6e,0x20,0x2a,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x29,
+    0x20,0x2a,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,
+    0x5f,0x31,0x32,0x30,0x2e,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,
+    0x72,0x69,0x78,0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x74,0x65,0x78,
+    0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,
+    0x20,0x3d,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,
+    0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,
+    0x3b,0x0a,0x7d,0x0a,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,
+    0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,
+    0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,0x30,0x20,0x5b,
+    0x5b,0x62,0x75,0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,
+    0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,
+    0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x70,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x33,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x33,0x28,0x30,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x32,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x20,0x3d,0x20,0x69,
+    0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x20,0x3d,
+    0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x65,0x6d,0x69,0x74,0x28,0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,
+    0x61,0x72,0x61,0x6d,0x5f,0x33,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,
+    0x6d,0x61,0x74,0x5f,0x78,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,
+    0x61,0x74,0x5f,0x79,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,
+    0x74,0x5f,0x7a,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,
+    0x5f,0x77,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
+    0x69,0x6f,0x6e,0x2c,0x20,0x5f,0x31,0x32,0x30,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,
+    0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x6f,0x75,0x74,
+    0x2e,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x6f,0x75,0x74,
+    0x2e,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x29,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,
+    0x00,
+};
+/*
+    #pragma clang diagnostic ignored "-Wmissing-prototypes"
+
+    #include <metal_stdlib>
+    #include <simd/simd.h>
+
+    using namespace metal;
+
+    struct vs_params
+    {
+        float4x4 texture_matrix;
+        float4x4 projection;
+    };
+
+    struct main0_out
+    {
+        float4 out_texcoord [[user(locn0)]];
+        float3 out_normal [[user(locn1)]];
+        float4 out_color [[user(locn2)]];
+        float4 gl_Position [[position]];
+    };
+
+    struct main0_in
+    {
+        float4 position [[attribute(0)]];
+        float4 color_v [[attribute(1)]];
+        float4 inst_mat_x [[attribute(2)]];
+        float4 inst_mat_y [[attribute(3)]];
+        float4 inst_mat_z [[attribute(4)]];
+        float4 inst_mat_w [[attribute(5)]];
+    };
+
+    static inline __attribute__((always_inline))
+    float4x4 make_matrix(thread const float4& x, thread const float4& y, thread const float4& z, thread const float4& w)
+    {
+        return float4x4(float4(x.x, y.x, z.x, w.x), float4(x.y, y.y, z.y, w.y), float4(x.z, y.z, z.z, w.z), float4(x.w, y.w, z.w, w.w));
+    }
+
+    static inline __attribute__((always_inline))
+    void emit(thread const float4& position, thread const float3& normal, thread const float2& texcoord, thread const float4& color, thread float4& inst_mat_x, thread float4& inst_mat_y, thread float4& inst_mat_z, thread float4& inst_mat_w, thread float4& gl_Position, constant vs_params& _120, thread float4& out_texcoord, thread float3& out_normal, thread float4& out_color)
+    {
+        float4 param = inst_mat_x;
+        float4 param_1 = inst_mat_y;
+        float4 param_2 = inst_mat_z;
+        float4 param_3 = inst_mat_w;
+        float4x4 modelview = make_matrix(param, param_1, param_2, param_3);
+        gl_Position = (_120.projection * modelview) * position;
+        out_texcoord = _120.texture_matrix * float4(texcoord, 0.0, 1.0);
+        out_normal = normal;
+        out_color = color;
+    }
+
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _120 [[buffer(0)]])
+    {
+        main0_out out = {};
+        float4 param = in.position;
+        float3 param_1 = float3(0.0);
+        float2 param_2 = float2(0.0);
+        float4 param_3 = in.color_v;
+        emit(param, param_1, param_2, param_3, in.inst_mat_x, in.inst_mat_y, in.inst_mat_z, in.inst_mat_w, out.gl_Position, _120, out.out_texcoord, out.out_normal, out.out_color);
+        return out;
+    }
+
+*/
+static const uint8_t vs_col_source_metal_macos[2187] = {
+    0x23,0x70,0x72,0x61,0x67,0x6d,0x61,0x20,0x63,0x6c,0x61,0x6e,0x67,0x20,0x64,0x69,
+    0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x20,0x69,0x67,0x6e,0x6f,0x72,0x65,0x64,
+    0x20,0x22,0x2d,0x57,0x6d,0x69,0x73,0x73,0x69,0x6e,0x67,0x2d,0x70,0x72,0x6f,0x74,
+    0x6f,0x74,0x79,0x70,0x65,0x73,0x22,0x0a,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,
+    0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,
+    0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,
+    0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,
+    0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,
+    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
+    0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,
+    0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x70,0x72,
+    0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,
+    0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,
+    0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x33,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,
+    0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,
+    0x6e,0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,
+    0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,
+    0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,
+    0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,
+    0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,0x20,0x5b,0x5b,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,
+    0x5f,0x78,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x32,
+    0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x20,0x5b,0x5b,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x33,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,
+    0x5f,0x7a,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x34,
+    0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x20,0x5b,0x5b,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x35,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,
+    0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x20,0x5f,
+    0x5f,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,0x61,0x6c,
+    0x77,0x61,0x79,0x73,0x5f,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,0x61,0x74,0x72,
+    0x69,0x78,0x28,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x78,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,
+    0x79,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x7a,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,
+    0x77,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x28,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,
+    0x78,0x2e,0x78,0x2c,0x20,0x79,0x2e,0x78,0x2c,0x20,0x7a,0x2e,0x78,0x2c,0x20,0x77,
+    0x2e,0x78,0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x79,0x2c,
+    0x20,0x79,0x2e,0x79,0x2c,0x20,0x7a,0x2e,0x79,0x2c,0x20,0x77,0x2e,0x79,0x29,0x2c,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x7a,0x2c,0x20,0x79,0x2e,0x7a,
+    0x2c,0x20,0x7a,0x2e,0x7a,0x2c,0x20,0x77,0x2e,0x7a,0x29,0x2c,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x34,0x28,0x78,0x2e,0x77,0x2c,0x20,0x79,0x2e,0x77,0x2c,0x20,0x7a,0x2e,
+    0x77,0x2c,0x20,0x77,0x2e,0x77,0x29,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x61,
+    0x74,0x69,0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,0x79,0x73,
+    0x5f,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,0x76,0x6f,0x69,0x64,0x20,0x65,
+    0x6d,0x69,0x74,0x28,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x33,0x26,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,
+    0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x32,0x26,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x74,
+    0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x26,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,
+    0x61,0x74,0x5f,0x78,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x2c,0x20,0x74,0x68,0x72,0x65,
+    0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,
+    0x6d,0x61,0x74,0x5f,0x77,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,
+    0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,0x30,0x2c,0x20,0x74,0x68,0x72,
+    0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x6f,0x75,0x74,0x5f,
+    0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x26,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,
+    0x6d,0x61,0x6c,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x26,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x29,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,
+    0x6d,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x3b,0x0a,
     0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,
-    0x5f,0x32,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,
-    0x5f,0x7a,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,
-    0x61,0x72,0x61,0x6d,0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,
-    0x5f,0x6d,0x61,0x74,0x5f,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,
-    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x28,0x5f,
-    0x31,0x30,0x32,0x2e,0x70,0x72,0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x20,0x2a,
-    0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x28,0x70,0x61,0x72,
-    0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,
-    0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x29,0x29,0x20,
-    0x2a,0x20,0x69,0x6e,0x2e,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,
-    0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,
-    0x6f,0x72,0x64,0x20,0x3d,0x20,0x5f,0x31,0x30,0x32,0x2e,0x74,0x65,0x78,0x74,0x75,
-    0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,
-    0x74,0x34,0x28,0x69,0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,
-    0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,
-    0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x3d,0x20,
-    0x69,0x6e,0x2e,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,
-    0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,
-    0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,
-    0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x5f,0x31,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,
+    0x6d,0x5f,0x32,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,
+    0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,
+    0x6d,0x6f,0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x20,0x3d,0x20,0x6d,0x61,0x6b,0x65,
+    0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x28,0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,
+    0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,
+    0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x67,
+    0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x28,0x5f,0x31,
+    0x32,0x30,0x2e,0x70,0x72,0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x20,0x2a,0x20,
+    0x6d,0x6f,0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x29,0x20,0x2a,0x20,0x70,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x74,
+    0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x5f,0x31,0x32,0x30,0x2e,0x74,
+    0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x20,0x2a,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,
+    0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x3d,0x20,0x6e,0x6f,0x72,
+    0x6d,0x61,0x6c,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,
+    0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x76,
+    0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
+    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,
+    0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,0x30,0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,0x65,
+    0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,
+    0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x31,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x28,0x30,0x2e,
+    0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x70,
+    0x61,0x72,0x61,0x6d,0x5f,0x32,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x28,
+    0x30,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,
+    0x6c,0x6f,0x72,0x5f,0x76,0x3b,0x0a,0x20,0x20,0x20,0x20,0x65,0x6d,0x69,0x74,0x28,
+    0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,
+    0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,
+    0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x2c,
+    0x20,0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,
+    0x69,0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x2c,0x20,0x69,
+    0x6e,0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x2c,0x20,0x6f,0x75,
+    0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x5f,
+    0x31,0x32,0x30,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,
+    0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x6e,
+    0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x63,
+    0x6f,0x6c,0x6f,0x72,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,
+    0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+};
+/*
+    #pragma clang diagnostic ignored "-Wmissing-prototypes"
+
+    #include <metal_stdlib>
+    #include <simd/simd.h>
+
+    using namespace metal;
+
+    struct vs_params
+    {
+        float4x4 texture_matrix;
+        float4x4 projection;
+    };
+
+    struct main0_out
+    {
+        float4 out_texcoord [[user(locn0)]];
+        float3 out_normal [[user(locn1)]];
+        float4 out_color [[user(locn2)]];
+        float4 gl_Position [[position]];
+    };
+
+    struct main0_in
+    {
+        float4 position [[attribute(0)]];
+        float2 texcoord [[attribute(1)]];
+        float2 normal_oct [[attribute(2)]];
+        float4 color_v [[attribute(3)]];
+        float4 inst_mat_x [[attribute(4)]];
+        float4 inst_mat_y [[attribute(5)]];
+        float4 inst_mat_z [[attribute(6)]];
+        float4 inst_mat_w [[attribute(7)]];
+    };
+
+    static inline __attribute__((always_inline))
+    float4x4 make_matrix(thread const float4& x, thread const float4& y, thread const float4& z, thread const float4& w)
+    {
+        return float4x4(float4(x.x, y.x, z.x, w.x), float4(x.y, y.y, z.y, w.y), float4(x.z, y.z, z.z, w.z), float4(x.w, y.w, z.w, w.w));
+    }
+
+    static inline __attribute__((always_inline))
+    void emit(thread const float4& position, thread const float3& normal, thread const float2& texcoord, thread const float4& color, thread float4& inst_mat_x, thread float4& inst_mat_y, thread float4& inst_mat_z, thread float4& inst_mat_w, thread float4& gl_Position, constant vs_params& _120, thread float4& out_texcoord, thread float3& out_normal, thread float4& out_color)
+    {
+        float4 param = inst_mat_x;
+        float4 param_1 = inst_mat_y;
+        float4 param_2 = inst_mat_z;
+        float4 param_3 = inst_mat_w;
+        float4x4 modelview = make_matrix(param, param_1, param_2, param_3);
+        gl_Position = (_120.projection * modelview) * position;
+        out_texcoord = _120.texture_matrix * float4(texcoord, 0.0, 1.0);
+        out_normal = normal;
+        out_color = color;
+    }
+
+    static inline __attribute__((always_inline))
+    float3 oct_decode(thread const float2& e)
+    {
+        float3 n = float3(e.x, e.y, (1.0 - abs(e.x)) - abs(e.y));
+        if (n.z < 0.0)
+        {
+            float2 s = float2((n.x >= 0.0) ? 1.0 : (-1.0), (n.y >= 0.0) ? 1.0 : (-1.0));
+            float2 _88 = (float2(1.0) - abs(n.yx)) * s;
+            n = float3(_88.x, _88.y, n.z);
+        }
+        return normalize(n);
+    }
+
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _120 [[buffer(0)]])
+    {
+        main0_out out = {};
+        float4 param = in.position;
+        float2 param_4 = in.normal_oct;
+        float3 param_1 = oct_decode(param_4);
+        float2 param_2 = in.texcoord;
+        float4 param_3 = in.color_v;
+        emit(param, param_1, param_2, param_3, in.inst_mat_x, in.inst_mat_y, in.inst_mat_z, in.inst_mat_w, out.gl_Position, _120, out.out_texcoord, out.out_normal, out.out_color);
+        return out;
+    }
+
+*/
+static const uint8_t vs_oct_source_metal_macos[2695] = {
+    0x23,0x70,0x72,0x61,0x67,0x6d,0x61,0x20,0x63,0x6c,0x61,0x6e,0x67,0x20,0x64,0x69,
+    0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x20,0x69,0x67,0x6e,0x6f,0x72,0x65,0x64,
+    0x20,0x22,0x2d,0x57,0x6d,0x69,0x73,0x73,0x69,0x6e,0x67,0x2d,0x70,0x72,0x6f,0x74,
+    0x6f,0x74,0x79,0x70,0x65,0x73,0x22,0x0a,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,
+    0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,
+    0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,
+    0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,
+    0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,
+    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
+    0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,
+    0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x70,0x72,
+    0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,
+    0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,
+    0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x33,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,
+    0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,
+    0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,
+    0x6e,0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,
+    0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,
+    0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,
+    0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,
+    0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,
+    0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x5f,
+    0x6f,0x63,0x74,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,
+    0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x76,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x33,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x34,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x35,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x36,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x37,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,
+    0x74,0x61,0x74,0x69,0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,
+    0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,
+    0x79,0x73,0x5f,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x78,0x34,0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,
+    0x28,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x78,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x79,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x26,0x20,0x7a,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x77,0x29,
+    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x78,0x34,0x28,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,
+    0x78,0x2c,0x20,0x79,0x2e,0x78,0x2c,0x20,0x7a,0x2e,0x78,0x2c,0x20,0x77,0x2e,0x78,
+    0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x79,0x2c,0x20,0x79,
+    0x2e,0x79,0x2c,0x20,0x7a,0x2e,0x79,0x2c,0x20,0x77,0x2e,0x79,0x29,0x2c,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x28,0x78,0x2e,0x7a,0x2c,0x20,0x79,0x2e,0x7a,0x2c,0x20,
+    0x7a,0x2e,0x7a,0x2c,0x20,0x77,0x2e,0x7a,0x29,0x2c,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x28,0x78,0x2e,0x77,0x2c,0x20,0x79,0x2e,0x77,0x2c,0x20,0x7a,0x2e,0x77,0x2c,
+    0x20,0x77,0x2e,0x77,0x29,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,
+    0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,0x79,0x73,0x5f,0x69,
+    0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,0x76,0x6f,0x69,0x64,0x20,0x65,0x6d,0x69,
+    0x74,0x28,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,
+    0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x33,0x26,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2c,0x20,0x74,0x68,
+    0x72,0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x32,0x26,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x74,0x68,0x72,
+    0x65,0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x26,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,
+    0x5f,0x78,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,0x74,
+    0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,
+    0x74,0x5f,0x77,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x26,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,
+    0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,
+    0x61,0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,0x30,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,
+    0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x26,0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,
+    0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x33,0x26,0x20,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,
+    0x6c,0x2c,0x20,0x74,0x68,0x72,0x65,0x61,0x64,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x26,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x29,0x0a,0x7b,0x0a,0x20,
+    0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x20,
+    0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,
+    0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,
+    0x32,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,0x61,0x6d,
+    0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x6f,
+    0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x20,0x3d,0x20,0x6d,0x61,0x6b,0x65,0x5f,0x6d,
+    0x61,0x74,0x72,0x69,0x78,0x28,0x70,0x61,0x72,0x61,0x6d,0x2c,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x32,0x2c,0x20,0x70,
+    0x61,0x72,0x61,0x6d,0x5f,0x33,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,
+    0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x28,0x5f,0x31,0x32,0x30,
+    0x2e,0x70,0x72,0x6f,0x6a,0x65,0x63,0x74,0x69,0x6f,0x6e,0x20,0x2a,0x20,0x6d,0x6f,
+    0x64,0x65,0x6c,0x76,0x69,0x65,0x77,0x29,0x20,0x2a,0x20,0x70,0x6f,0x73,0x69,0x74,
+    0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,
+    0x63,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x5f,0x31,0x32,0x30,0x2e,0x74,0x65,0x78,
+    0x74,0x75,0x72,0x65,0x5f,0x6d,0x61,0x74,0x72,0x69,0x78,0x20,0x2a,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x28,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2c,0x20,0x30,
+    0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,
+    0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x3d,0x20,0x6e,0x6f,0x72,0x6d,0x61,
+    0x6c,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x61,
+    0x74,0x69,0x63,0x20,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x20,0x5f,0x5f,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x5f,0x5f,0x28,0x28,0x61,0x6c,0x77,0x61,0x79,0x73,
+    0x5f,0x69,0x6e,0x6c,0x69,0x6e,0x65,0x29,0x29,0x0a,0x66,0x6c,0x6f,0x61,0x74,0x33,
+    0x20,0x6f,0x63,0x74,0x5f,0x64,0x65,0x63,0x6f,0x64,0x65,0x28,0x74,0x68,0x72,0x65,
+    0x61,0x64,0x20,0x63,0x6f,0x6e,0x73,0x74,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x26,
+    0x20,0x65,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,
+    0x20,0x6e,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x28,0x65,0x2e,0x78,0x2c,
+    0x20,0x65,0x2e,0x79,0x2c,0x20,0x28,0x31,0x2e,0x30,0x20,0x2d,0x20,0x61,0x62,0x73,
+    0x28,0x65,0x2e,0x78,0x29,0x29,0x20,0x2d,0x20,0x61,0x62,0x73,0x28,0x65,0x2e,0x79,
+    0x29,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,0x66,0x20,0x28,0x6e,0x2e,0x7a,0x20,
+    0x3c,0x20,0x30,0x2e,0x30,0x29,0x0a,0x20,0x20,0x20,0x20,0x7b,0x0a,0x20,0x20,0x20,
+    0x20,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x73,0x20,0x3d,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x32,0x28,0x28,0x6e,0x2e,0x78,0x20,0x3e,0x3d,0x20,0x30,
+    0x2e,0x30,0x29,0x20,0x3f,0x20,0x31,0x2e,0x30,0x20,0x3a,0x20,0x28,0x2d,0x31,0x2e,
+    0x30,0x29,0x2c,0x20,0x28,0x6e,0x2e,0x79,0x20,0x3e,0x3d,0x20,0x30,0x2e,0x30,0x29,
+    0x20,0x3f,0x20,0x31,0x2e,0x30,0x20,0x3a,0x20,0x28,0x2d,0x31,0x2e,0x30,0x29,0x29,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,
+    0x20,0x5f,0x38,0x38,0x20,0x3d,0x20,0x28,0x66,0x6c,0x6f,0x61,0x74,0x32,0x28,0x31,
+    0x2e,0x30,0x29,0x20,0x2d,0x20,0x61,0x62,0x73,0x28,0x6e,0x2e,0x79,0x78,0x29,0x29,
+    0x20,0x2a,0x20,0x73,0x3b,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x6e,0x20,
+    0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x28,0x5f,0x38,0x38,0x2e,0x78,0x2c,0x20,
+    0x5f,0x38,0x38,0x2e,0x79,0x2c,0x20,0x6e,0x2e,0x7a,0x29,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x7d,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6e,0x6f,
+    0x72,0x6d,0x61,0x6c,0x69,0x7a,0x65,0x28,0x6e,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x76,
+    0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
+    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,
+    0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,
+    0x6d,0x73,0x26,0x20,0x5f,0x31,0x32,0x30,0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,0x65,
+    0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,
+    0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x34,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x6e,0x6f,0x72,0x6d,0x61,0x6c,
+    0x5f,0x6f,0x63,0x74,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,
+    0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x20,0x3d,0x20,0x6f,0x63,0x74,0x5f,0x64,
+    0x65,0x63,0x6f,0x64,0x65,0x28,0x70,0x61,0x72,0x61,0x6d,0x5f,0x34,0x29,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x70,0x61,0x72,0x61,0x6d,
+    0x5f,0x32,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x70,0x61,0x72,
+    0x61,0x6d,0x5f,0x33,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x5f,
+    0x76,0x3b,0x0a,0x20,0x20,0x20,0x20,0x65,0x6d,0x69,0x74,0x28,0x70,0x61,0x72,0x61,
+    0x6d,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x31,0x2c,0x20,0x70,0x61,0x72,0x61,
+    0x6d,0x5f,0x32,0x2c,0x20,0x70,0x61,0x72,0x61,0x6d,0x5f,0x33,0x2c,0x20,0x69,0x6e,
+    0x2e,0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x78,0x2c,0x20,0x69,0x6e,0x2e,
+    0x69,0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x79,0x2c,0x20,0x69,0x6e,0x2e,0x69,
+    0x6e,0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x7a,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x6e,
+    0x73,0x74,0x5f,0x6d,0x61,0x74,0x5f,0x77,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,
+    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x5f,0x31,0x32,0x30,0x2c,
+    0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,
+    0x64,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x6e,0x6f,0x72,0x6d,0x61,
+    0x6c,0x2c,0x20,0x6f,0x75,0x74,0x2e,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,0x6f,0x72,
+    0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,
+    0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     #include <metal_stdlib>
@@ -231,17 +1048,18 @@ static const uint8_t vs_source_metal_macos[1535] = {
     struct main0_in
     {
         float4 out_texcoord [[user(locn0)]];
+        float4 out_color [[user(locn2)]];
     };
 
     fragment main0_out main0(main0_in in [[stage_in]], texture2d<float> texture_v [[texture(0)]], sampler sampler_v [[sampler(0)]])
     {
         main0_out out = {};
-        out.frag_color = texture_v.sample(sampler_v, in.out_texcoord.xy);
+        out.frag_color = texture_v.sample(sampler_v, in.out_texcoord.xy) * in.out_color;
         return out;
     }
 
 */
-static const uint8_t fs_source_metal_macos[438] = {
+static const uint8_t fs_source_metal_macos[491] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
@@ -253,23 +1071,26 @@ static const uint8_t fs_source_metal_macos[438] = {
     0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,
     0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
     0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x75,
-    0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,
-    0x0a,0x0a,0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,
-    0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,
-    0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,
-    0x6e,0x5d,0x5d,0x2c,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x32,0x64,0x3c,0x66,
-    0x6c,0x6f,0x61,0x74,0x3e,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x76,0x20,
-    0x5b,0x5b,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,
-    0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x20,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x5f,
-    0x76,0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,
-    0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,
-    0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,
-    0x6f,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,
-    0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x76,0x2e,0x73,0x61,0x6d,0x70,0x6c,
-    0x65,0x28,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x5f,0x76,0x2c,0x20,0x69,0x6e,0x2e,
-    0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,0x29,
-    0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,
-    0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6f,0x75,0x74,0x5f,0x63,0x6f,0x6c,
+    0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x32,0x29,
+    0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,
+    0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,
+    0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,
+    0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x74,0x65,0x78,0x74,0x75,
+    0x72,0x65,0x32,0x64,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x3e,0x20,0x74,0x65,0x78,0x74,
+    0x75,0x72,0x65,0x5f,0x76,0x20,0x5b,0x5b,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,
+    0x30,0x29,0x5d,0x5d,0x2c,0x20,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x20,0x73,0x61,
+    0x6d,0x70,0x6c,0x65,0x72,0x5f,0x76,0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,
+    0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,
+    0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x5f,0x63,
+    0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x76,
+    0x2e,0x73,0x61,0x6d,0x70,0x6c,0x65,0x28,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x5f,
+    0x76,0x2c,0x20,0x69,0x6e,0x2e,0x6f,0x75,0x74,0x5f,0x74,0x65,0x78,0x63,0x6f,0x6f,
+    0x72,0x64,0x2e,0x78,0x79,0x29,0x20,0x2a,0x20,0x69,0x6e,0x2e,0x6f,0x75,0x74,0x5f,
+    0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,
+    0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 static inline const sg_shader_desc* sim_shader_desc(sg_backend backend) {
     if (backend == SG_BACKEND_METAL_MACOS) {
@@ -298,3 +1119,84 @@ static inline const sg_shader_desc* sim_shader_desc(sg_backend backend) {
     }
     return 0;
 }
+static inline const sg_shader_desc* sim_uv_shader_desc(sg_backend backend) {
+    if (backend == SG_BACKEND_METAL_MACOS) {
+        static sg_shader_desc desc;
+        static bool valid;
+        if (!valid) {
+            valid = true;
+            desc.vs.source = (const char*)vs_uv_source_metal_macos;
+            desc.vs.entry = "main0";
+            desc.vs.uniform_blocks[0].size = 128;
+            desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+            desc.fs.source = (const char*)fs_source_metal_macos;
+            desc.fs.entry = "main0";
+            desc.fs.images[0].used = true;
+            desc.fs.images[0].multisampled = false;
+            desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+            desc.fs.images[0].sample_type = SG_IMAGESAMPLETYPE_FLOAT;
+            desc.fs.samplers[0].used = true;
+            desc.fs.samplers[0].sampler_type = SG_SAMPLERTYPE_FILTERING;
+            desc.fs.image_sampler_pairs[0].used = true;
+            desc.fs.image_sampler_pairs[0].image_slot = 0;
+            desc.fs.image_sampler_pairs[0].sampler_slot = 0;
+            desc.label = "sim_uv_shader";
+        }
+        return &desc;
+    }
+    return 0;
+}
+static inline const sg_shader_desc* sim_col_shader_desc(sg_backend backend) {
+    if (backend == SG_BACKEND_METAL_MACOS) {
+        static sg_shader_desc desc;
+        static bool valid;
+        if (!valid) {
+            valid = true;
+            desc.vs.source = (const char*)vs_col_source_metal_macos;
+            desc.vs.entry = "main0";
+            desc.vs.uniform_blocks[0].size = 128;
+            desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+            desc.fs.source = (const char*)fs_source_metal_macos;
+            desc.fs.entry = "main0";
+            desc.fs.images[0].used = true;
+            desc.fs.images[0].multisampled = false;
+            desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+            desc.fs.images[0].sample_type = SG_IMAGESAMPLETYPE_FLOAT;
+            desc.fs.samplers[0].used = true;
+            desc.fs.samplers[0].sampler_type = SG_SAMPLERTYPE_FILTERING;
+            desc.fs.image_sampler_pairs[0].used = true;
+            desc.fs.image_sampler_pairs[0].image_slot = 0;
+            desc.fs.image_sampler_pairs[0].sampler_slot = 0;
+            desc.label = "sim_col_shader";
+        }
+        return &desc;
+    }
+    return 0;
+}
+static inline const sg_shader_desc* sim_oct_shader_desc(sg_backend backend) {
+    if (backend == SG_BACKEND_METAL_MACOS) {
+        static sg_shader_desc desc;
+        static bool valid;
+        if (!valid) {
+            valid = true;
+            desc.vs.source = (const char*)vs_oct_source_metal_macos;
+            desc.vs.entry = "main0";
+            desc.vs.uniform_blocks[0].size = 128;
+            desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+            desc.fs.source = (const char*)fs_source_metal_macos;
+            desc.fs.entry = "main0";
+            desc.fs.images[0].used = true;
+            desc.fs.images[0].multisampled = false;
+            desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+            desc.fs.images[0].sample_type = SG_IMAGESAMPLETYPE_FLOAT;
+            desc.fs.samplers[0].used = true;
+            desc.fs.samplers[0].sampler_type = SG_SAMPLERTYPE_FILTERING;
+            desc.fs.image_sampler_pairs[0].used = true;
+            desc.fs.image_sampler_pairs[0].image_slot = 0;
+            desc.fs.image_sampler_pairs[0].sampler_slot = 0;
+            desc.label = "sim_oct_shader";
+        }
+        return &desc;
+    }
+    return 0;
+}
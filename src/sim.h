@@ -209,7 +209,9 @@ enum {
     SIM_DRAW_LINES = 0x0002,
     SIM_DRAW_LINE_STRIP = 0x0003,
     SIM_DRAW_TRIANGLES = 0x0004,
-    SIM_DRAW_TRIANGLE_STRIP = 0x0005
+    SIM_DRAW_TRIANGLE_STRIP = 0x0005,
+    // 4 vertices per quad, drawn through a shared index buffer
+    SIM_DRAW_QUADS = 0x0007
 };
 
 enum {
@@ -256,12 +258,49 @@ enum {
     SIM_WRAP_MIRRORED_REPEAT
 };
 
+enum {
+    SIM_VERTEX_FORMAT_DEFAULT = 0,            /* picked per batch from the attributes actually written */
+    SIM_VERTEX_FORMAT_FULL,                   /* float4 position, float3 normal, float2 uv, float4 color (52 bytes) */
+    SIM_VERTEX_FORMAT_POS2_UV_RGBA8,          /* float2 position, float2 uv, rgba8 color (20 bytes) */
+    SIM_VERTEX_FORMAT_POS3_UV_RGBA8,          /* float3 position, float2 uv, rgba8 color (24 bytes) */
+    SIM_VERTEX_FORMAT_POS3_RGBA8,             /* float3 position, rgba8 color (16 bytes) */
+    SIM_VERTEX_FORMAT_POS3_HALF_UV_OCT_RGBA8, /* float3 position, half2 uv, octahedral normal, rgba8 color (24 bytes) */
+    SIM_VERTEX_FORMAT_POS2_UV_COLOR,          /* float2 position, float2 uv, float4 color (32 bytes) */
+    SIM_VERTEX_FORMAT_POS3_UV_COLOR,          /* float3 position, float2 uv, float4 color (36 bytes) */
+    SIM_VERTEX_FORMAT_POS3_COLOR,             /* float3 position, float4 color (28 bytes) */
+    SIM_VERTEX_FORMAT_COUNT
+};
+
+enum {
+    SIM_DRAW_ORDER_DEFAULT = 0,
+    SIM_DRAW_ORDER_SUBMISSION,
+    SIM_DRAW_ORDER_SORTED
+};
+
 EXPORT void sim_set_window_size(int width, int height);
 EXPORT void sim_set_window_title(const char *title);
+// Runs the loop callback on its own thread one frame ahead of submission,
+// at the cost of a frame of latency. The loop may only record draws, the
+// same restrictions as sim_recorder_begin apply. Set before sim_run.
+EXPORT void sim_set_pipelined(int enabled);
+// Rasterizes on the CPU instead of the GPU, the same vertex and fragment
+// stages, depth, cull and blend modes, binned into tiles that are drawn in
+// parallel. Only headless runs and render targets use it, threads < 0 is
+// one per core and 0 turns it off. Set before sim_run_headless.
+EXPORT void sim_set_software_renderer(int threads);
 EXPORT void sim_set_init_callback(void(*callback)(void));
 EXPORT void sim_set_loop_callback(void(*callback)(double));
 EXPORT void sim_set_exit_callback(void(*callback)(void));
 EXPORT int sim_run(void);
+// Runs the same callbacks for a fixed number of frames without a window,
+// rendering into an offscreen RGBA8 target of the given size. Needs either
+// SOKOL_DUMMY_BACKEND or SIM_EGL (GL through a surfaceless EGL context,
+// link with -lEGL). Returns -1 if no device could be created, that is the
+// only failure reported, anything else asserts like the rest of the library.
+EXPORT int sim_run_headless(int width, int height, int frames);
+// Pixels of the last headless frame, width*height RGBA8 top row first,
+// NULL if the backend can't read them back (the dummy backend)
+EXPORT const unsigned char* sim_headless_pixels(void);
 
 EXPORT int sim_window_width(void);
 EXPORT int sim_window_height(void);
@@ -313,6 +352,23 @@ EXPORT void sim_scissor_rect(int x, int y, int width, int height);
 EXPORT void sim_blend_mode(int mode);
 EXPORT void sim_depth_func(int func);
 EXPORT void sim_cull_mode(int mode);
+// Format the following sim_begin() batches are uploaded in. The default
+// drops the normals, uvs and z of batches that never set them, which is
+// lossless; the RGBA8 and octahedral formats quantise. Batches given
+// through sim_vertex_array() keep the array's layout.
+EXPORT void sim_vertex_format(int format);
+// SIM_DRAW_ORDER_SORTED sorts the draws of each pass by layer, then opaque
+// draws front to back grouped by pipeline and texture and blended draws
+// back to front. The default keeps submission order.
+EXPORT void sim_draw_order(int order);
+// Batches recorded with the same contents as an earlier one are drawn from
+// a cached immutable buffer instead of being uploaded again. frames is how
+// long an unused buffer is kept, 0 disables it and a negative value uses
+// DEFAULT_RETAIN_FRAMES.
+EXPORT void sim_auto_retain(int frames);
+// Layer (0-255) of the following draws, lower layers are drawn first when
+// the draw order is SIM_DRAW_ORDER_SORTED. Ignored in submission order.
+EXPORT void sim_draw_layer(int layer);
 
 EXPORT void sim_begin(int mode);
 EXPORT void sim_vertex2i(int x, int y);
@@ -323,9 +379,52 @@ EXPORT void sim_normal3f(float x, float y, float z);
 EXPORT void sim_color4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
 EXPORT void sim_color3f(float x, float y, float z);
 EXPORT void sim_color4f(float x, float y, float z, float w);
+EXPORT void sim_vertex_array(const void *data, int count, int stride, int layout);
+EXPORT void sim_index(int index);
+EXPORT void sim_index_array(const int *indices, int count);
 EXPORT void sim_draw(void);
 EXPORT void sim_end(void);
 
+// Recorders let other threads record draws in parallel with the loop
+// callback. Create them (up to MAX_RECORDERS per context) on the main
+// thread, even while workers are bound, bind one per worker with
+// sim_recorder_begin and unbind it with sim_recorder_end before the loop
+// callback returns. Their draws are submitted after the main thread's,
+// in the order the recorders were created. Workers may only record:
+// textures, buffers, atlases and display lists stay on the main thread.
+EXPORT int sim_recorder_create(void);
+EXPORT void sim_recorder_begin(int recorder);
+EXPORT void sim_recorder_end(void);
+
+// Contexts are independent renderers, each with its own draw state,
+// command queue and streams, while textures, buffers, atlases and display
+// lists are shared between them. Every thread records into the context it
+// made current, the default one if it never did, so contexts can record in
+// parallel. Draws recorded into a context other than the default one look
+// up their pipelines when it is rendered, and sim_auto_retain only applies
+// to the default context. sim_context_render submits a context into a
+// render target and like every other sokol call must happen on the main
+// thread.
+typedef struct sim_context_t sim_context_t;
+EXPORT sim_context_t* sim_context_create(void);
+EXPORT void sim_context_destroy(sim_context_t *context);
+EXPORT void sim_context_make_current(sim_context_t *context);
+EXPORT sim_context_t* sim_context_current(void);
+EXPORT void sim_context_render(sim_context_t *context, int target);
+
+EXPORT int sim_render_target_create(int width, int height);
+EXPORT int sim_render_target_texture(int target);
+EXPORT void sim_render_target_release(int target);
+
+// Display lists compile the batches recorded between sim_list_begin and
+// sim_list_end into GPU buffers without drawing them. sim_call_list replays
+// them under the current modelview and projection. Lists are compiled on
+// the main thread, any context may call them.
+EXPORT void sim_list_begin(void);
+EXPORT int sim_list_end(void);
+EXPORT void sim_call_list(int list);
+EXPORT void sim_release_list(int list);
+
 EXPORT int sim_empty_texture(int width, int height);
 EXPORT void sim_push_texture(int texture);
 EXPORT void sim_pop_texture(void);
@@ -335,10 +434,67 @@ EXPORT void sim_set_texture_filter(int min, int mag);
 EXPORT void sim_set_texture_wrap(int wrap_u, int wrap_v);
 EXPORT void sim_release_texture(int texture);
 
+// Atlases pack many small images into shared pages so they can be drawn
+// without switching textures. Regions are addressed by the handle
+// sim_atlas_add returns (0 if the image is larger than a page); use
+// sim_atlas_texture and sim_atlas_uv to draw them. A negative padding
+// uses DEFAULT_ATLAS_PADDING.
+EXPORT int sim_atlas_create(int width, int height, int padding);
+EXPORT int sim_atlas_add(int atlas, unsigned char *data, int data_size);
+EXPORT int sim_atlas_add_pixels(int atlas, const int *pixels, int width, int height);
+EXPORT int sim_atlas_texture(int atlas, int region);
+EXPORT void sim_atlas_uv(int atlas, int region, float *u0, float *v0, float *u1, float *v1);
+EXPORT void sim_atlas_destroy(int atlas);
+
+// Sprites are batched per texture and drawn as quads the next time another
+// draw is recorded, or at the end of the frame. color is 0xRRGGBBAA and
+// rotation is in radians about the sprite's centre.
+EXPORT void sim_sprite(int texture, float x, float y, float w, float h, float u0, float v0, float u1, float v1, unsigned int color, float rotation);
+
 EXPORT int sim_store_buffer(void);
+EXPORT int sim_store_vertex_array(const void *data, int count, int stride, int layout);
 EXPORT void sim_load_buffer(int buffer);
 EXPORT void sim_release_buffer(int buffer);
 
+EXPORT void sim_reserve_vertices(int count);
+EXPORT int sim_vertex_high_water_mark(void);
+EXPORT int sim_vertex_stream_used(void);
+EXPORT int sim_vertex_stream_capacity(void);
+EXPORT int sim_pipeline_cache_hits(void);
+EXPORT int sim_pipeline_cache_misses(void);
+
+// What the last completed frame did. vertices counts every instance's
+// vertices (or indices), bytes_uploaded is everything handed to
+// sg_make_buffer, sg_append_buffer and sg_update_image. loop_ms is the
+// loop callback and submit_ms the submit walk and commit in frame(), both
+// CPU time from sokol_time. sokol holds sokol_gfx's own counters.
+typedef struct {
+    int draws;
+    int vertices;
+    int instances;
+    int commands;
+    int pipelines_created;
+    int pipelines_destroyed;
+    int samplers_created;
+    int samplers_destroyed;
+    int buffers_created;
+    int buffers_destroyed;
+    long long bytes_uploaded;
+    double loop_ms;
+    double submit_ms;
+    struct {
+        int passes;
+        int apply_pipeline;
+        int apply_bindings;
+        int apply_uniforms;
+        int draws;
+        long long uniform_bytes;
+        long long buffer_bytes;
+        long long image_bytes;
+    } sokol;
+} sim_frame_stats_t;
+EXPORT sim_frame_stats_t sim_frame_stats(void);
+
 #undef EXPORT
 
 #if defined(__cplusplus)
@@ -55,12 +55,12 @@ static void init(void) {
     texture = sim_load_texture_path("/Users/george/Downloads/pear.jpg");
     
     sim_begin(SIM_DONT_CARE);
-    for (int i = 0; i < 36; i++) {
-        int j = indices[i];
-        float *data = vertices + j * 5;
+    for (int i = 0; i < 24; i++) {
+        float *data = vertices + i * 5;
         sim_texcoord2f(data[3], data[4]);
         sim_vertex3f(data[0], data[1], data[2]);
     }
+    sim_index_array(indices, 36);
     buffer = sim_store_buffer();
     sim_end();
 }